@@ -0,0 +1,77 @@
+#include <Internal/Internal.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace kui;
+
+/*
+* Compares the UTF-8 decoder used by the text pipeline against a loop decoding one character at a time.
+* Build it in release mode, the timings of a debug build don't mean much.
+*/
+
+using DecodeFunction = void(*)(std::string_view, std::u32string&, std::vector<uint32_t>*);
+
+static std::string RepeatToSize(const std::string& Part, size_t Size)
+{
+	std::string Result;
+	while (Result.size() < Size)
+	{
+		Result += Part;
+	}
+	return Result;
+}
+
+static double MeasureDecode(DecodeFunction Decode, const std::string& Text, size_t Iterations)
+{
+	std::u32string Characters;
+	std::vector<uint32_t> Offsets;
+	// Decode once before measuring, so the buffers are already allocated.
+	Decode(Text, Characters, &Offsets);
+
+	auto Start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < Iterations; i++)
+	{
+		Decode(Text, Characters, &Offsets);
+	}
+	auto End = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(End - Start).count();
+}
+
+static bool RunBenchmark(const std::string& Name, const std::string& Text)
+{
+	constexpr size_t Iterations = 50;
+
+	std::u32string FastCharacters, ScalarCharacters;
+	std::vector<uint32_t> FastOffsets, ScalarOffsets;
+	internal::DecodeUTF8(Text, FastCharacters, &FastOffsets);
+	internal::DecodeUTF8Scalar(Text, ScalarCharacters, &ScalarOffsets);
+	if (FastCharacters != ScalarCharacters || FastOffsets != ScalarOffsets)
+	{
+		std::cout << Name << ": The results of both decoders are different." << std::endl;
+		return false;
+	}
+
+	double ScalarTime = MeasureDecode(&internal::DecodeUTF8Scalar, Text, Iterations);
+	double FastTime = MeasureDecode(&internal::DecodeUTF8, Text, Iterations);
+	double Megabytes = double(Text.size()) * Iterations / 1000000.0;
+
+	std::cout << Name << " (" << Text.size() / 1000 << " KB, " << Iterations << " times)" << std::endl;
+	std::cout << "  Scalar loop: " << ScalarTime << " ms, " << Megabytes / ScalarTime * 1000.0 << " MB/s" << std::endl;
+	std::cout << "  DecodeUTF8:  " << FastTime << " ms, " << Megabytes / FastTime * 1000.0 << " MB/s" << std::endl;
+	std::cout << "  Speedup:     " << ScalarTime / FastTime << "x" << std::endl;
+	return true;
+}
+
+int main()
+{
+	constexpr size_t TextSize = 1000000;
+
+	std::string Ascii = RepeatToSize("The quick brown fox jumps over the lazy dog.\n\tLorem ipsum dolor sit amet, consectetur adipiscing elit.\n", TextSize);
+	std::string Mixed = RepeatToSize("Gr\xC3\xBC\xC3\x9F" "e aus M\xC3\xBCnchen! \xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF "
+		"\xF0\x9F\x98\x80 Some ASCII text in between the other characters.\n", TextSize);
+
+	bool Success = RunBenchmark("ASCII text", Ascii);
+	Success = RunBenchmark("Mixed text", Mixed) && Success;
+	return Success ? 0 : 1;
+}
@@ -2,10 +2,21 @@
 #include "Vec2.h"
 #include "Vec3.h"
 #include <vector>
+#include <unordered_map>
 #include <cstdint>
+#include <string>
+#include <thread>
+#include <atomic>
+
+struct stbtt_fontinfo;
 
 namespace kui
 {
+	namespace resource
+	{
+		struct BinaryData;
+	}
+
 	class ScrollObject;
 	/**
 	 * @brief
@@ -38,27 +49,98 @@ namespace kui
 		}
 	};
 
-	struct FontVertex
+	/**
+	 * @brief
+	 * A single glyph of a drawn text, as it is stored in the instance buffer. The quad is expanded by text.vert.
+	 */
+	struct GlyphInstance
 	{
-		Vec2f position;
-		Vec2f texCoords;
-		Vec3f color = 1;
+		/// The position of the glyph's line relative to the origin of it's run, in 1/16 font units.
+		int16_t X = 0, Y = 0;
+		/// The atlas slot of the glyph, used to look up it's metrics.
+		uint16_t Slot = 0;
+		uint16_t Padding = 0;
+		/// RGBA8 color.
+		uint32_t Color = 0;
 	};
 
 	class Shader;
+	class Font;
+	class TextLayout;
 	class DrawableText
 	{
 		friend class Font;
-		unsigned int VAO = 0, VBO = 0;
+
+		/**
+		 * @brief
+		 * The vertices of a fixed number of lines of the text.
+		 *
+		 * Only blocks that are visible are drawn and generated again after the text has changed.
+		 */
+		struct TextBlock
+		{
+			/**
+			 * @brief
+			 * Glyphs that are positioned relative to the same origin.
+			 *
+			 * Instance positions only have 16 bits, so very long lines need more than one run.
+			 */
+			struct Run
+			{
+				unsigned int FirstGlyph = 0;
+				unsigned int NumGlyphs = 0;
+				Vec2f Origin;
+			};
+			std::vector<Run> Runs;
+
+			unsigned int VAO = 0, VBO = 0;
+			/// The number of glyphs the instance buffer has space for.
+			unsigned int BufferCapacity = 0;
+			unsigned int NumGlyphs = 0;
+			/// The atlas generation the vertices were generated with.
+			uint32_t AtlasGeneration = 0;
+			/// True if the lines of this block have changed since the vertices were generated.
+			bool Outdated = true;
+		};
+		std::vector<TextBlock> Blocks;
+		void SetBlockCount(size_t NewCount);
+		static void BindInstanceAttributes(unsigned int FirstGlyph);
+
+		/// The font that generated the vertices.
+		Font* TextFont = nullptr;
+		/// The version of the layout the blocks have been updated with.
+		uint64_t LayoutVersion = 0;
 		unsigned int Texture = 0;
 		Vec3f Color = 0;
 		float Scale = 0;
+		bool SDF = false;
 		Vec2f Position;
-		unsigned int NumVerts = 0;
-		DrawableText(unsigned int VAO, unsigned int VBO, unsigned int NumVerts, unsigned int Texture, Vec2f Position, float Scale, Vec3f Color, float opacity);
+		DrawableText();
 	public:
 		float Opacity = 1.0f;
 		void Draw(ScrollObject* CurrentScrollObject) const;
+
+		/**
+		 * @brief
+		 * Moves the text to a new screen position.
+		 *
+		 * The position is applied when drawing, so the vertices of the text don't have to be generated again.
+		 */
+		void SetPosition(Vec2f NewPosition);
+
+		/**
+		 * @brief
+		 * Gets the range of lines that are visible inside the given scroll object and the window.
+		 */
+		void GetVisibleLines(ScrollObject* CurrentScrollObject, size_t& OutFirst, size_t& OutEnd) const;
+
+		/**
+		 * @brief
+		 * True if glyphs used by this text have been removed from the font's atlas.
+		 *
+		 * The text has to be generated again with Font::UpdateText() before drawing it.
+		 */
+		bool IsOutdated() const;
 		~DrawableText();
 	};
 
@@ -71,30 +153,234 @@ namespace kui
 		friend class DrawableText;
 	private:
 		static Shader* GetTextShader();
+		resource::BinaryData* FontFile = nullptr;
+		stbtt_fontinfo* FontInfo = nullptr;
 		unsigned int fontTexture = 0;
-		unsigned int fontVao = 0;
-		unsigned int fontVertexBufferId = 0;
-		FontVertex* fontVertexBufferData = 0;
-		uint32_t fontVertexBufferCapacity = 0;
+		/// RGBA32F texture containing two texels for every atlas slot: the texture coordinates and the quad of the glyph in the slot.
+		/// Each row contains GlyphMetricsRowSlots slots.
+		unsigned int GlyphMetricsTexture = 0;
+		/// The number of rows the metrics texture has been allocated with.
+		size_t GlyphMetricsRows = 0;
+		/// CPU copy of the glyph metrics texture, 8 floats per slot.
+		std::vector<float> GlyphMetrics;
+		/// The range of slots that have changed since the metrics were uploaded.
+		size_t FirstChangedSlot = SIZE_MAX, EndChangedSlot = 0;
+		void UploadGlyphMetrics();
+		/// Instances of the text block that is currently being generated.
+		std::vector<GlyphInstance> InstanceData;
+
+		struct AtlasShelf
+		{
+			int Y = 0;
+			int Height = 0;
+			int UsedWidth = 0;
+		};
+
+		/// CPU copy of the atlas texture, used when the texture has to grow.
+		std::vector<uint8_t> AtlasPixels;
+		int AtlasSize = 0;
+		std::vector<AtlasShelf> AtlasShelves;
+		/// The number of slots that have been allocated in the atlas since it was last reset.
+		size_t AtlasSlotCount = 0;
+		/// Incremented for every generated text. Glyphs used by the text being generated are never evicted.
+		uint64_t GlyphUseCounter = 0;
+		/// Incremented every time glyphs are removed from the atlas.
+		uint32_t AtlasGeneration = 0;
+		/// True if the atlas had to grow larger than the budget allows.
+		bool AtlasOverBudget = false;
+		bool UseSDF = false;
+
+		struct KerningPair
+		{
+			/// The first glyph index in the upper and the second one in the lower 16 bits.
+			uint32_t Key = UINT32_MAX;
+			float Advance = 0;
+		};
+		/**
+		 * Open addressed hash table of kerning pairs, with a power of two size. Empty if the font has no kerning.
+		 *
+		 * Pairs are added the first time they are looked up, including pairs without kerning,
+		 * so the font's kerning tables are only searched once per pair.
+		 */
+		mutable std::vector<KerningPair> KerningTable;
+		/// The longest distance from a pair's hash to the slot it is stored in.
+		mutable uint32_t KerningMaxProbe = 0;
+		mutable size_t KerningPairCount = 0;
+		void LoadKerningTable();
+		void AddKerningPair(uint32_t Key, float Advance) const;
+
+		/// A glyph bitmap rendered while loading the font, before the atlas is available.
+		struct PreloadedBitmap
+		{
+			int Width = 0, Height = 0, OffsetX = 0, OffsetY = 0;
+			std::vector<uint8_t> Pixels;
+		};
+		std::unordered_map<char32_t, PreloadedBitmap> PreloadedBitmaps;
+
+		std::thread LoadThread;
+		/// Set by the loading thread once it has finished.
+		std::atomic<bool> LoadThreadDone = false;
+		/// True once the results of loading have been applied on the thread using the font.
+		bool Loaded = false;
+		std::string LoadError;
+		void LoadFile(std::string FileName);
+		void FinishLoading();
+
+		/// The directory of the atlas cache, copied from AtlasCacheDirectory when the font is created.
+		std::string CacheDirectory;
+		/// Hash of the font file, used to find the atlas cache of the font.
+		uint64_t FontHash = 0;
+		/// Contents of the cache file read by the loading thread, applied on the GL thread.
+		std::vector<uint8_t> LoadedCacheData;
+		/// True if glyphs have been added to the atlas since it was loaded from or saved to the cache.
+		bool AtlasCacheOutdated = false;
+		std::string GetAtlasCachePath() const;
+		bool ReadAtlasCache(std::vector<uint8_t>& OutData) const;
+		bool ApplyAtlasCache(const std::vector<uint8_t>& Data);
+		void UploadAtlas();
 	public:
+		/**
+		 * @brief
+		 * Directory where fonts store their glyph atlas, so glyphs don't have to be rendered again by the next process.
+		 *
+		 * Caching is disabled if this is empty. Only affects fonts created after it has been set.
+		 * The cache of a font is written by SaveAtlasCache() and when the font is destroyed.
+		 */
+		static std::string AtlasCacheDirectory;
+
+		/**
+		 * @brief
+		 * Writes the glyph atlas and metrics of this font to the cache directory.
+		 *
+		 * @return
+		 * True if the cache has been written.
+		 */
+		bool SaveAtlasCache();
+
 		float CharacterSize = 0;
 		struct Glyph
 		{
 			Vec2f Size;
 			Vec2f Offset;
 			Vec2f TotalSize;
+			/// The index of the glyph in the font file.
+			int GlyphIndex = 0;
+			/// Texture coordinates in atlas pixels. Only valid if Rasterized is true.
 			Vec2f TexCoordStart;
 			Vec2f TexCoordOffset;
+
+			/// The area of the atlas reserved for this glyph, including padding.
+			int SlotX = 0, SlotY = 0, SlotWidth = 0, SlotHeight = 0;
+			/// The index of the slot in the glyph metrics buffer.
+			uint16_t SlotIndex = 0;
+			bool Rasterized = false;
+			uint64_t LastUsed = 0;
 		};
-		std::vector<Glyph> LoadedGlyphs;
+
+		/**
+		 * @brief
+		 * The maximum size of the glyph atlas texture in bytes.
+		 *
+		 * Glyphs are only rendered into the atlas once they are needed. If the atlas is full,
+		 * the least recently used glyphs are replaced.
+		 */
+		size_t AtlasMemoryBudget = 2048 * 2048;
+
+		/**
+		 * @brief
+		 * Gets the metrics of a character. Loads the character if it hasn't been used before.
+		 *
+		 * The glyph isn't rendered into the atlas by this function.
+		 */
+		Glyph& GetGlyph(char32_t Character);
+
+		/**
+		 * @brief
+		 * Enables or disables signed distance field rendering for this font.
+		 *
+		 * SDF glyphs stay sharp at every text size and DPI scale, so a single font can be used for both small texts and headings.
+		 * Changing the mode clears the glyph atlas. Texts using the font are generated again when they are drawn next.
+		 */
+		void SetSDFEnabled(bool NewEnabled);
+		bool GetSDFEnabled() const;
+
+		/**
+		 * @brief
+		 * Gets the kerning between two glyphs, which is added to the advance of the first one.
+		 *
+		 * The value is in the same units as Glyph::TotalSize. Pairs without kerning return 0.
+		 */
+		float GetKerning(int FirstGlyphIndex, int SecondGlyphIndex) const;
 
 		uint8_t TabSize = 4;
-		size_t GetCharacterAtPosition(std::vector<TextSegment> Text, Vec2f Position, float Scale, bool Wrapped, float LengthBeforeWrap, uint32_t MaxLines);
-		Font(std::string filename);
-		Vec2f GetTextSize(std::vector<TextSegment> Text, float Scale, bool Wrapped, float LengthBeforeWrap, uint32_t MaxLines, Vec2f* EndPos = nullptr, size_t EndIndex = SIZE_MAX);
-		DrawableText* MakeText(std::vector<TextSegment> Text, Vec2f Pos, float Scale, Vec3f Color, float opacity, float LengthBeforeWrap, uint32_t MaxLines);
+		size_t GetCharacterAtPosition(const std::vector<TextSegment>& Text, Vec2f Position, float Scale, bool Wrapped, float LengthBeforeWrap, uint32_t MaxLines);
+		/**
+		 * @brief
+		 * Loads a font file.
+		 *
+		 * @param LoadAsync
+		 * If true, the font file is loaded and the most common glyphs are rendered on background threads.
+		 * The font can be used immediately. UIText elements using it stay empty until loading has finished,
+		 * everything else that needs the font's metrics waits for it.
+		 */
+		Font(std::string filename, bool LoadAsync = false);
+
+		/**
+		 * @brief
+		 * True if the font has finished loading.
+		 *
+		 * Always true for fonts that were not loaded asynchronously.
+		 */
+		bool IsLoaded();
+
+		/**
+		 * @brief
+		 * Blocks until the font has finished loading.
+		 */
+		void WaitForLoading();
+		Vec2f GetTextSize(const std::vector<TextSegment>& Text, float Scale, bool Wrapped, float LengthBeforeWrap, uint32_t MaxLines, Vec2f* EndPos = nullptr, size_t EndIndex = SIZE_MAX);
+		DrawableText* MakeText(const std::vector<TextSegment>& Text, Vec2f Pos, float Scale, Vec3f Color, float opacity, float LengthBeforeWrap, uint32_t MaxLines);
+
+		/**
+		 * @brief
+		 * Creates a DrawableText from a text that has already been laid out with this font.
+		 *
+		 * The vertices are only generated by UpdateVisibleText(), which has to be called before drawing the text.
+		 */
+		DrawableText* MakeText(const TextLayout& Layout, Vec2f Pos, Vec3f Color, float opacity);
+
+		/**
+		 * @brief
+		 * Generates the vertices of a DrawableText created by this font again, reusing it's vertex buffer.
+		 *
+		 * The vertex buffer only grows if the new text doesn't fit in it.
+		 */
+		void UpdateText(DrawableText* Target, const std::vector<TextSegment>& Text, Vec2f Pos, float Scale, Vec3f Color, float opacity, float LengthBeforeWrap, uint32_t MaxLines);
+
+		/**
+		 * @brief
+		 * Updates a DrawableText from a text that has already been laid out with this font.
+		 *
+		 * Only the lines that changed since the last update are marked as outdated.
+		 * Their vertices are generated by UpdateVisibleText() once they are visible.
+		 */
+		void UpdateText(DrawableText* Target, const TextLayout& Layout, Vec2f Pos, Vec3f Color, float opacity);
+
+		/**
+		 * @brief
+		 * Generates the vertices of all outdated lines of the text that are visible inside the given scroll object.
+		 */
+		void UpdateVisibleText(DrawableText* Target, const TextLayout& Layout, ScrollObject* CurrentScrollObject);
 		~Font();
 
+	private:
+		std::unordered_map<char32_t, Glyph> LoadedGlyphs;
+
+		void ResizeAtlas(int NewSize);
+		void ResetAtlas();
+		bool AllocateAtlasSlot(Glyph& Target, int Width, int Height);
+		void RasterizeGlyph(char32_t Character, Glyph& Target);
+		void GenerateTextBlocks(DrawableText* Target, const TextLayout& Layout, size_t FirstBlock, size_t EndBlock);
 	};
 
 }
\ No newline at end of file
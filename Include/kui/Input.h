@@ -206,5 +206,41 @@ namespace kui
 		std::string GetSelectedTextString() const;
 
 		void SetTextIndex(int NewIndex, bool ClearSelection);
+
+		/**
+		 * @brief
+		 * A change made to Text by the input manager.
+		 */
+		struct TextEdit
+		{
+			/// The index of the first changed byte.
+			size_t Start = 0;
+			size_t RemovedLength = 0;
+			std::string Inserted;
+		};
+
+		/**
+		 * @brief
+		 * Incremented every time the input manager changes Text.
+		 *
+		 * Assigning Text directly doesn't change the revision.
+		 */
+		uint64_t TextRevision = 0;
+
+		/**
+		 * @brief
+		 * Gets the changes made to Text since the given revision, oldest first.
+		 *
+		 * This allows text fields to only update the changed part of a long text.
+		 *
+		 * @return
+		 * False if the changes aren't known anymore. The whole text has to be read again in that case.
+		 */
+		bool GetTextEditsSince(uint64_t Revision, std::vector<TextEdit>& OutEdits) const;
+
+	private:
+		/// The most recent changes to Text. The last one has the revision TextRevision.
+		std::vector<TextEdit> RecentTextEdits;
+		void EditText(size_t Start, size_t RemovedLength, const std::string& Inserted = "");
 	};
 }
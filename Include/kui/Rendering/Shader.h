@@ -20,6 +20,7 @@ namespace kui
 		void SetFloat(const std::string& Name, float Value);
 		void SetVec2(const std::string& Name, Vec2f Value);
 		void SetVec3(const std::string& Name, Vec3f Value);
+		void SetVec4(const std::string& Name, float X, float Y, float Z, float W);
 	private:
 		unsigned int GetUniformLocation(const std::string& Name) const;
 		unsigned int ShaderID = 0;
@@ -7,6 +7,7 @@ namespace kui
 {
 	class Shader;
 	struct VertexBuffer;
+	struct BackgroundBatch;
 
 	/**
 	 * @brief
@@ -26,15 +27,29 @@ namespace kui
 		virtual void DrawBackground();
 		Vec3f Color;
 		static thread_local VertexBuffer* BoxVertexBuffer;
+		static thread_local BackgroundBatch* Batch;
 		unsigned int TextureID = 0;
 		float Opacity = 1;
 		Vec3f ColorMultiplier = 1;
 		static float GetBorderSize(UISize InSize);
+		Vec3f GetScrollOffset() const;
+		/// The default UI shader. Only backgrounds drawn with it can be batched, so UISpinner and UIBlurBackground are drawn directly.
+		Shader* DefaultShader = nullptr;
+		bool IsBatchedDraw() const override;
 
 	public:
 
 		static void FreeVertexBuffer();
 
+		/**
+		 * @brief
+		 * Draws all batched backgrounds.
+		 *
+		 * Backgrounds using the default UI shader are collected and drawn together. Anything drawn directly with OpenGL
+		 * has to call this first, so the batched backgrounds are drawn below it.
+		 */
+		static void FlushBatch();
+
 		Shader* BackgroundShader = nullptr;
 		bool HasTexture() const
 		{
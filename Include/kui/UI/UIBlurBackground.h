@@ -4,15 +4,37 @@
 
 namespace kui
 {
+	/**
+	 * @brief
+	 * A background that blurs the UI drawn behind it.
+	 *
+	 * The blurred image is cached, and only created again when something behind the background has changed.
+	 * Changes to the background's own children only redraw the changed area.
+	 */
 	class UIBlurBackground : public UIBackground
 	{
 	protected:
+		/// The number of textures in the blur pyramid. Each one has half the size of the previous one.
+		static constexpr unsigned int BlurLevels = 4;
+
+		/**
+		 * @brief
+		 * Gets the size of the largest texture of the blur pyramid, which contains the blurred image.
+		 */
 		Vec2ui GetPixelSize();
+		Vec2ui GetLevelSize(unsigned int Level);
 		bool BuffersLoaded = false;
-		unsigned int BackgroundBuffers[2], BackgroundTextures[2];
+		unsigned int BackgroundBuffers[BlurLevels], BackgroundTextures[BlurLevels];
 		Shader* BlurShader = nullptr;
 		Vec2ui OldSize;
+		/// The format of the blur textures. They are created again when the framebuffer format of the UI changes.
+		UIManager::FramebufferFormat BuffersFormat = UIManager::FramebufferFormat::RGBA8;
+		/// True if the UI behind this background has changed since it was last blurred.
+		bool BlurDirty = true;
+		/// The area of the window that has last been blurred.
+		UIManager::RedrawBox BlurredBox = UIManager::RedrawBox{ .Min = NAN, .Max = NAN };
 		void CreateBlurBuffers();
+		void BlurBehind();
 		static thread_local std::set<UIBlurBackground*> BlurBackgrounds;
 		friend class UIManager;
 	public:
@@ -22,4 +44,4 @@ namespace kui
 		void Draw() override;
 
 	};
-}
\ No newline at end of file
+}
@@ -3,14 +3,22 @@
 #include <set>
 #include <vector>
 #include <cmath>
+#include <cstdint>
 #include <kui/UI/UIManager.h>
 #include <kui/UISize.h>
 
+namespace kui::internal
+{
+	class LayerCache;
+	class HoverIndex;
+}
+
 namespace kui
 {
 	class ScrollObject;
 	class UIButton;
 	class UIScrollBox;
+	class UIBlurBackground;
 	class Window;
 
 	/**
@@ -57,18 +65,40 @@ namespace kui
 		 * UIBox destructor.
 		 *
 		 * When deleted, a UIBox will also delete all children.
+		 *
+		 * A child that is deleted on its own is removed from the children of its parent,
+		 * which takes time proportional to the number of children. To remove all children, use DeleteChildren().
 		 */
 		virtual ~UIBox();
 		virtual void OnAttached();
 
 		/**
 		* @brief
-		* Invalidates the layout of this UIBox, causing the position and scale of this UIBox and all children to be recalculated on the next UI update.
+		* Invalidates the layout of this UIBox, causing the position and scale of this UIBox to be recalculated on the next UI update.
+		*
+		* Only this box and its parents are marked as dirty. Siblings and children are only laid out again
+		* if their size or position changes as a result.
 		*
 		* This function is called by all functions that modify any value that changes the position or scale.
 		*/
 		void InvalidateLayout();
 
+		/**
+		 * @brief
+		 * Checks if the size of this UIBox can depend on its children.
+		 *
+		 * If a child of a layout boundary is invalidated, only the boundary and its children are laid out again,
+		 * instead of the entire hierarchy.
+		 *
+		 * By default, a UIBox is a layout boundary if its minimum size is equal to its maximum size.
+		 * This also applies to UIScrollBox, which doesn't override this function. A scroll box without
+		 * a fixed size still sizes itself to its content, so it isn't a boundary.
+		 *
+		 * @return
+		 * True if the size of this UIBox does not depend on its children.
+		 */
+		virtual bool IsLayoutBoundary() const;
+
 		/**
 		 * @brief
 		 * Adds the given UIBox to this UIBox's children.
@@ -83,8 +113,10 @@ namespace kui
 		/**
 		 * @brief
 		 * Deletes all children of this element.
+		 *
+		 * The children are detached all at once, so this is faster than deleting every child separately.
 		 */
-		void DeleteChildren();
+		virtual void DeleteChildren();
 
 		/**
 		 * @brief
@@ -97,10 +129,30 @@ namespace kui
 		 * ```
 		 *
 		 * UIBox C is not visible in the hierarchy since any invisible UIBox will not render it's children.
+		 *
+		 * The result is cached. It is updated by SetVisible() as soon as the visibility of this box or any of it's parents changes.
 		 */
-		bool IsVisibleInHierarchy();
+		bool IsVisibleInHierarchy() const;
 		bool IsBeingHovered();
 
+		/**
+		 * @brief
+		 * Draws this UIBox and it's children into a separate texture, which is reused until something inside of it changes.
+		 *
+		 * Useful for large boxes that rarely change, like a sidebar with many icons and labels.
+		 * Redrawing an area that overlaps the box then only draws the texture instead of all children.
+		 *
+		 * Anything drawn outside of this box is cut off.
+		 *
+		 * Blur backgrounds need the image of everything behind them, so a box containing a blur background is drawn
+		 * without the layer.
+		 *
+		 * @return
+		 * A pointer to this UIBox.
+		 */
+		UIBox* SetLayerCached(bool NewLayerCached);
+		bool GetLayerCached() const;
+
 		/**
 		 * @brief
 		 * Sets the maximum size this UIBox can occupy.
@@ -203,6 +255,8 @@ namespace kui
 		/**
 		 * @brief
 		 * Moves this UIBox to the front of the window, on top of all other elements.
+		 *
+		 * Only has an effect on boxes without a parent.
 		 */
 		void MoveToFront();
 
@@ -288,11 +342,56 @@ namespace kui
 		 */
 		bool HasMouseCollision = false;
 
+		/**
+		 * @brief
+		 * Sets the visibility of the UIBox. Invisible boxes don't draw themselves or their children.
+		 *
+		 * @return
+		 * A pointer to this UIBox.
+		 */
+		UIBox* SetVisible(bool NewVisible);
+		bool GetVisible() const;
+
+		/**
+		 * @brief
+		 * Wrapper that keeps code using the old IsVisible member compiling.
+		 *
+		 * Assigning a value calls SetVisible(), reading it calls GetVisible().
+		 */
+		class VisibleProperty
+		{
+		public:
+			VisibleProperty(UIBox* Owner)
+				: Owner(Owner)
+			{
+			}
+			VisibleProperty(const VisibleProperty&) = delete;
+
+			VisibleProperty& operator=(bool NewVisible)
+			{
+				Owner->SetVisible(NewVisible);
+				return *this;
+			}
+			VisibleProperty& operator=(const VisibleProperty& Other)
+			{
+				return *this = bool(Other);
+			}
+			operator bool() const
+			{
+				return Owner->GetVisible();
+			}
+		private:
+			UIBox* Owner = nullptr;
+		};
+
 		/**
 		 * @brief
 		 * Controls the visibility of the UIBox.
+		 *
+		 * @deprecated
+		 * Use SetVisible() and GetVisible() instead. This will be removed in a future version.
 		 */
-		bool IsVisible = true;
+		VisibleProperty IsVisible = VisibleProperty(this);
 
 		bool KeyboardFocusable = false;
 
@@ -307,8 +406,32 @@ namespace kui
 		const std::vector<UIBox*>& GetChildren();
 
 		void UpdateElement();
+
+		/**
+		 * @brief
+		 * Updates ShouldBeTicked after the visibility of this UIBox in the hierarchy has changed.
+		 */
 		virtual void UpdateTickState();
 
+		/**
+		 * @brief
+		 * Enables or disables calling Tick() on this UIBox every frame.
+		 *
+		 * Ticking is disabled by default. Elements should only enable it while they need to do work every frame,
+		 * for example while a button is hovered or a text field is being edited. The hovered box and the box
+		 * with keyboard focus always have ticking enabled.
+		 *
+		 * @param NewTickEnabled
+		 * True if Tick() should be called every frame, false if not.
+		 */
+		void SetTickEnabled(bool NewTickEnabled);
+
+		/**
+		 * @brief
+		 * Checks if Tick() is called on this UIBox every frame.
+		 */
+		bool GetTickEnabled() const;
+
 		/**
 		 * @brief
 		 * Gets the parent of this UIBox.
@@ -342,14 +465,58 @@ namespace kui
 	protected:
 		bool ShouldBeTicked = true;
 		bool Redrawn = false;
+		/**
+		 * @brief
+		 * True if Draw() doesn't draw directly with OpenGL, so the background batch doesn't have to be flushed before it.
+		 * See UIBackground::FlushBatch().
+		 *
+		 * This is only true for plain UIBoxes by default, since a subclass might draw with OpenGL in an overridden Draw().
+		 * Subclasses that don't draw directly can return true, so they don't break up the batch.
+		 */
+		virtual bool IsBatchedDraw() const;
+
+		/**
+		 * @brief
+		 * True if ticking should be enabled while this box is hovered or has keyboard focus.
+		 *
+		 * Boxes that return true have to disable ticking again themselves once they are idle.
+		 * This is false by default, so hovering a box that doesn't react to the mouse doesn't make it tick.
+		 */
+		virtual bool WantsHoverTick() const;
 	private:
-		bool PrevIsVisible = true;
+		bool Visible = true;
+		/// Cached result of IsVisibleInHierarchy().
+		bool VisibleInHierarchy = true;
 		bool ChildrenHorizontal = true;
+		/// True if the size of this box has to be measured again.
+		bool MeasureDirty = true;
+		/// True if the children of this box have to be positioned again.
+		bool ArrangeDirty = true;
+		/// Index of this box in UIManager::TickedElements, or SIZE_MAX if ticking is disabled.
+		size_t TickIndex = SIZE_MAX;
+		/// Index of this box in UIManager::UIElements.
+		size_t ElementIndex = 0;
+		UIBox* PrevRoot = nullptr;
+		UIBox* NextRoot = nullptr;
+		/**
+		 * Increases with every attach, so siblings and roots that are drawn later have a larger value.
+		 * Removing a box doesn't change the order of the others, so it never has to be renumbered.
+		 */
+		uint64_t SiblingOrder = 0;
+		bool IsBeingDestroyed = false;
+		/// The cached image of this box and it's children, if SetLayerCached() is enabled.
+		internal::LayerCache* Layer = nullptr;
+		/// The number of UIBlurBackgrounds that are this box or one of its children.
+		size_t BlurBackgroundsInside = 0;
 	protected:
 		virtual void Update();
 		virtual void Draw();
+
+		/**
+		 * @brief
+		 * Called every frame while ticking is enabled. See SetTickEnabled().
+		 */
 		virtual void Tick();
-		void UpdateHoveredState();
 		Vec2f Position;
 		Vec2f OffsetPosition = NAN;
 		SizeVec MaxSize = UISize::Largest();
@@ -372,10 +539,27 @@ namespace kui
 
 		float GetVerticalOffset();
 		float GetHorizontalOffset();
+		bool DependsOnParentSize() const;
+		void UpdateVisibleInHierarchy();
+		void AssignSiblingOrder();
+		Vec2f MeasureSize() const;
+		bool ApplySize(Vec2f NewSize);
 		void UpdateScale();
 		void UpdatePosition();
+		/// Moves this box in UIManager::HoverBoxIndex after its position, size or scroll object has changed.
+		void UpdateHoverEntry();
+		/**
+		 * @brief
+		 * Adds Difference to BlurBackgroundsInside of this box and all of its parents.
+		 */
+		void AddBlurBackgroundsInside(int64_t Difference);
+		bool LayerContainsBlur() const;
+		void DrawLayer(const UIManager::RedrawBox& Box);
 
 
 		friend UIManager;
+		friend UIScrollBox;
+		friend UIBlurBackground;
+		friend internal::HoverIndex;
 	};
 }
\ No newline at end of file
@@ -36,6 +36,7 @@ namespace kui
 		};
 		ButtonState CurrentButtonState = ButtonState::Normal;
 		void Tick() override;
+		bool WantsHoverTick() const override;
 		virtual void OnButtonClicked();
 	public:
 
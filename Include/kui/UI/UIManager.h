@@ -5,6 +5,12 @@
 #include <functional>
 #include "../Vec2.h"
 
+namespace kui::internal
+{
+	class HoverIndex;
+	class DamageMap;
+}
+
 namespace kui
 {
 	class UIBox;
@@ -19,33 +25,100 @@ namespace kui
 		std::map<unsigned int, ReferenceTexture> ReferencedTextures;
 		std::string TexturePath;
 
-		Vec2ui ScissorXY, ScissorWH;
+		/// The areas of the window that have to be redrawn on the next frame.
+		internal::DamageMap* Damage = nullptr;
+		size_t LastDamagedPixels = 0;
+		size_t LastDamagedRects = 0;
 
 		UIBox* GetNextKeyboardBox(UIBox* From, bool Reverse);
 		UIBox* FindKeyboardBox(UIBox* From, bool Reverse);
 
+		/// The laid out rectangles of all boxes. Boxes update their entry when they are moved or resized.
+		internal::HoverIndex* HoverBoxIndex = nullptr;
+		bool HoveredBoxDirty = true;
+		Vec2f LastHoverPosition;
+
+		/// Elements that are drawn into a cached layer. See UIBox::SetLayerCached().
+		std::vector<UIBox*> LayerBoxes;
+
+		/// Elements without a parent, linked through UIBox::PrevRoot and UIBox::NextRoot in drawing order.
+		UIBox* FirstRoot = nullptr;
+		UIBox* LastRoot = nullptr;
+		/// The next value of UIBox::SiblingOrder.
+		uint64_t NextSiblingOrder = 0;
+
+		void UpdateHoveredBox();
+		void AddRoot(UIBox* Root);
+		void RemoveRoot(UIBox* Root);
+
+		friend UIBox;
+
 	public:
 		UIManager();
 		~UIManager();
 
 		thread_local static bool UseAlphaBuffer;
 
+		/**
+		 * @brief
+		 * The pixel format of the texture the UI is drawn to.
+		 */
+		enum class FramebufferFormat
+		{
+			/// 8 bits per channel. Enough for UI that doesn't need values outside of 0 - 1.
+			RGBA8,
+			/// 16 bit floats per channel. Uses twice the memory and blending bandwidth of RGBA8.
+			RGBA16F,
+		};
+
+		/**
+		 * @brief
+		 * Sets the pixel format of the texture the UI is drawn to. The default is RGBA8.
+		 *
+		 * The UI texture is created again and the UI is redrawn if the format changes.
+		 */
+		void SetFramebufferFormat(FramebufferFormat NewFormat);
+		FramebufferFormat GetFramebufferFormat() const;
+
+		/**
+		 * @brief
+		 * Gets the size of the UI textures.
+		 *
+		 * This can be larger than the window. Only the bottom left corner with the size of the window is used.
+		 */
+		Vec2ui GetFramebufferSize() const;
+
+		/**
+		 * @brief
+		 * Gets the scale from texture coordinates over the window to texture coordinates in the UI textures.
+		 */
+		Vec2f GetFramebufferUVScale() const;
+
 		/**
 		* @brief
 		* The UI element that is currently hovered.
 		*/
 		UIBox* HoveredBox = nullptr;
-		UIBox* NewHoveredBox = nullptr;
 		UIBox* KeyboardFocusBox = nullptr;
 
 		std::set<UIBox*> ElementsToUpdate;
+		/// All elements of this window, in no particular order.
 		std::vector<UIBox*> UIElements;
+		/// Elements that are ticked every frame. See UIBox::SetTickEnabled().
+		std::vector<UIBox*> TickedElements;
 		bool RequiresRedraw = true;
 		bool DrawToWindow = true;
 		unsigned int UIBuffer = 0;
 		unsigned int UITextures[2];
 
 		void ForceUpdateUI();
+		/**
+		 * @brief
+		 * Creates the UI textures if they don't exist, or if they don't fit the window size or format anymore.
+		 *
+		 * The textures grow with some extra space, and only shrink again once the window is less than half as wide or high,
+		 * so resizing a window doesn't reallocate them every frame.
+		 */
 		void InitUI();
 		unsigned int GetUIFramebuffer() const;
 		void RedrawUI();
@@ -55,8 +128,36 @@ namespace kui
 		bool DrawElements();
 		void TickElements();
 
+		/**
+		 * @brief
+		 * The number of pixels that were redrawn by the last call to DrawElements() that drew anything.
+		 */
+		size_t GetDamagedPixelArea() const;
+
+		/**
+		 * @brief
+		 * The number of separate rectangles that were redrawn by the last call to DrawElements() that drew anything.
+		 */
+		size_t GetDamagedRectCount() const;
+
+		/**
+		 * @brief
+		 * Gets the damage map of the window, which also stores the rectangles drawn in the last frames.
+		 *
+		 * Used to present only the changed parts of the window.
+		 */
+		const internal::DamageMap* GetDamageMap() const;
+
 		void UpdateEvents();
 
+		/**
+		 * @brief
+		 * Finds the hovered box again on the next frame, even if the mouse hasn't moved.
+		 *
+		 * Called when elements are scrolled or their visibility changes.
+		 */
+		void InvalidateHoveredBox();
+
 		/**
 		 * @brief
 		 * Loads a reference-counted texture.
@@ -101,7 +202,22 @@ namespace kui
 			static bool IsBoxOverlapping(const UIManager::RedrawBox& BoxA, const UIManager::RedrawBox& BoxB);
 		};
 
-		std::vector<RedrawBox> RedrawBoxes;
-		void RedrawArea(RedrawBox Box);
+		/**
+		 * @brief
+		 * Marks an area of the window to be redrawn on the next frame.
+		 *
+		 * @param Source
+		 * The box that has changed, if the area belongs to a single box.
+		 * Blur backgrounds containing it don't have to be blurred again.
+		 */
+		void RedrawArea(RedrawBox Box, UIBox* Source = nullptr);
+
+	private:
+		FramebufferFormat Format = FramebufferFormat::RGBA8;
+		/// The format the UI textures have been allocated with.
+		FramebufferFormat AllocatedFormat = FramebufferFormat::RGBA8;
+		/// The size of the UI textures. Can be larger than the window, so resizing doesn't always reallocate them.
+		Vec2ui FramebufferSize;
+		void FreeFramebuffer();
 	};
 }
\ No newline at end of file
@@ -51,6 +51,19 @@ namespace kui
 		float DesiredMaxScroll = 0;
 		float GetDesiredChildrenSize();
 		void UpdateScrollObjectOfObject(UIBox* o);
+
+		bool Virtualized = false;
+		size_t VirtualItemCount = 0;
+		UISize VirtualItemHeight;
+		std::function<UIBox*()> CreateVirtualItem;
+		std::function<void(UIBox* Item, size_t Index)> UpdateVirtualItem;
+		/// The boxes currently displaying items, starting with the item at FirstVirtualItem.
+		std::vector<UIBox*> VirtualItems;
+		size_t FirstVirtualItem = 0;
+		float VirtualItemScreenHeight = 0;
+		UIBox* VirtualTopSpacer = nullptr;
+		UIBox* VirtualBottomSpacer = nullptr;
+		void UpdateVirtualItems(bool UpdateAll);
 	public:
 		std::function<void(UIScrollBox* This)> OnScroll;
 		
@@ -68,11 +81,55 @@ namespace kui
 
 		void SetMaxScroll(float NewMaxScroll);
 		float GetMaxScroll() const;
+
+		/**
+		 * @brief
+		 * Makes this scroll box virtualized.
+		 *
+		 * A virtualized scroll box only creates boxes for the items that are visible in it, plus VirtualOverscan items
+		 * above and below them. When scrolling, boxes of items that are no longer visible are reused for other items.
+		 *
+		 * All existing children of this scroll box are deleted, and the children are managed by the scroll box
+		 * from now on. The scroll box has to lay out it's children vertically. While it is virtualized, children can't be
+		 * added or deleted one by one. DeleteChildren() deletes all items and makes the scroll box a normal one again.
+		 *
+		 * @param ItemCount
+		 * The number of items.
+		 *
+		 * @param ItemHeight
+		 * The height of every item box, including it's padding.
+		 * Items are placed at multiples of this height, starting at the top of the scroll box, so the padding
+		 * of the scroll box is ignored and the created boxes have to be exactly this tall.
+		 *
+		 * @param CreateItem
+		 * Creates a new box that can display an item.
+		 *
+		 * @param UpdateItem
+		 * Makes a box created by CreateItem display the item with the given index.
+		 */
+		UIScrollBox* SetVirtualItems(size_t ItemCount, UISize ItemHeight,
+			std::function<UIBox*()> CreateItem,
+			std::function<void(UIBox* Item, size_t Index)> UpdateItem);
+
+		/**
+		 * @brief
+		 * Sets the number of items of a virtualized scroll box. All visible items are updated again.
+		 */
+		UIScrollBox* SetVirtualItemCount(size_t NewItemCount);
+		size_t GetVirtualItemCount() const;
+
+		/// The number of items created above and below the visible items of a virtualized scroll box.
+		size_t VirtualOverscan = 4;
 		void Update() override;
 		void UpdateTickState() override;
 		void Tick() override;
+		void DeleteChildren() override;
 		UIScrollBox(bool Horizontal, Vec2f Position, bool DisplayScrollBar);
 		~UIScrollBox();
+
+	protected:
+		bool IsBatchedDraw() const override;
+		bool WantsHoverTick() const override;
 	};
 
 }
\ No newline at end of file
@@ -16,9 +16,18 @@ namespace kui
 		UISpinner* SetSpeed(float NewSpeed);
 		UISpinner* SetBackgroundColor(Vec3f NewColor);
 
+		/**
+		 * @brief
+		 * Sets if the spinner is animated. An inactive spinner is not ticked.
+		 */
+		UISpinner* SetActive(bool NewActive);
+		bool GetActive() const;
+
 		void Tick() override;
 		virtual void Draw() override;
 
+	private:
+		/// Only changed by SetActive(), since an inactive spinner stops ticking.
 		bool Active = true;
 	};
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "UIBox.h"
 #include "../Font.h"
+#include "../TextLayout.h"
 #include "../Vec3.h"
 
 namespace kui
@@ -23,15 +24,21 @@ namespace kui
 		float TextWidthOverride = 0;
 		float Opacity = 1.0f;
 		float GetRenderedSize() const;
-		float GetWrapDistance() const;
+		float GetScreenWrapDistance() const;
+
+		/// Only changed by SetWrapEnabled(), which invalidates the layout of the text.
+		UISize WrapDistance = 0.0f;
+		bool Wrap = false;
+
+		/// The layout is updated lazily by const functions like GetLetterLocation().
+		mutable TextLayout Layout;
+		const TextLayout& GetLayout() const;
 	public:
 		UIText* SetFont(Font* NewFont);
 		Font* GetTextFont() const;
 		void Tick() override;
 		SizeMode WrapSizeMode = SizeMode::ScreenRelative;
 		SizeMode TextSizeMode = SizeMode::ScreenRelative;
-		UISize WrapDistance = 0.0f;
-		bool Wrap = false;
 		Vec3f GetColor() const;
 		/**
 		 * @brief
@@ -78,6 +85,8 @@ namespace kui
 		 * A pointer to this UIText.
 		 */
 		UIText* SetWrapEnabled(bool WrapEnabled, UISize WrapDistance);
+		bool GetWrapEnabled() const;
+		UISize GetWrapDistance() const;
 
 		/**
 		 * @brief
@@ -90,6 +99,23 @@ namespace kui
 		 * Sets the text of this UIText from a list of TextSegments.
 		 */
 		UIText* SetText(std::vector<TextSegment> NewText);
+
+		/**
+		 * @brief
+		 * Replaces a part of the text.
+		 *
+		 * Only the lines of the changed paragraph are laid out again, which makes editing long texts much cheaper than SetText().
+		 *
+		 * @param Start
+		 * The byte index of the first replaced character.
+		 *
+		 * @param RemovedLength
+		 * The number of bytes to remove at Start.
+		 *
+		 * @param Inserted
+		 * The string to insert at Start.
+		 */
+		void EditText(size_t Start, size_t RemovedLength, const std::string& Inserted);
 		std::string GetText() const;
 
 		/**
@@ -131,12 +157,14 @@ namespace kui
 		void OnAttached() override;
 		SizeVec GetUsedSize() override;
 
+	protected:
+		bool IsBatchedDraw() const override;
+
 	private:
-		bool LastWrapEnabled = false;
-		bool TextChanged = false;
-		float LastRenderSize = 0;
-		float LastAspect = 0;
-		Vec2f LastSize;
-		float LastWrapDistance = 0;
+		/// The version of the layout the vertices of the text were generated from.
+		uint64_t DrawnLayoutVersion = 0;
+		Font* DrawnFont = nullptr;
+		/// True if the text has been waiting for it's font to finish loading.
+		bool WaitingForFont = false;
 	};
 }
\ No newline at end of file
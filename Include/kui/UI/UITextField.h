@@ -34,10 +34,20 @@ namespace kui
 		std::string HintText; // Will be displayed when the text field is empty
 		bool Dragging = false;
 
+		/// The revision of the input manager's text that has been applied to EnteredText.
+		uint64_t SeenTextRevision = 0;
+		bool ShowingHint = false;
+		/// True if the text object has to be set to the entered text or hint text again.
+		bool DisplayedTextChanged = true;
+		void SetInputText();
+		void UpdateEnteredText();
+
 		Vec2f TextHighlightStart;
 		ScrollObject TextScroll = ScrollObject(0, 1, 1);
 		//ScrollObject TextRenderScroll = ScrollObject(0, 1, 1, false);
 		Vec2f TextHighlightEnd;
+	protected:
+		bool WantsHoverTick() const override;
 	public:
 		bool CanEdit = true;
 		bool AllowNewLine = false;
@@ -5,15 +5,18 @@ in vec2 v_texcoords;
 uniform sampler2D u_ui;
 uniform bool u_hasWindowBorder;
 uniform vec3 u_borderColor;
+uniform vec2 u_screenRes;
+// The UI texture can be larger than the window.
+uniform vec2 u_uvScale;
 
 void main()
 {
-	f_color.xyz = texture(u_ui, v_texcoords).xyz;
+	f_color.xyz = texture(u_ui, v_texcoords * u_uvScale).xyz;
 	f_color.w = 1.0;
 
 	if (u_hasWindowBorder)
 	{
-		vec2 EdgeSize = vec2(1.0) / vec2(textureSize(u_ui, 0));
+		vec2 EdgeSize = vec2(1.0) / u_screenRes;
 		if (v_texcoords.x <= EdgeSize.x)
 		{
 			f_color = vec4(u_borderColor, 1.0);
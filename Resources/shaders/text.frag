@@ -10,6 +10,7 @@ uniform vec3 textColor;
 uniform float u_opacity;
 uniform vec2 u_screenRes;
 uniform vec3 transform;
+uniform bool u_sdf;
 #define NUM_SAMPLES 3
 
 void main()
@@ -23,12 +24,26 @@ void main()
 		discard;
 	}
 	float sampled = 0.0;
-	vec2 offset = (1.5 / transform.z) / u_screenRes;
+	// Texture coordinates are given in atlas pixels, since the atlas can grow.
+	vec2 atlasSize = vec2(textureSize(u_texture, 0));
+	vec2 uv = TexCoords / atlasSize;
+	if (u_sdf)
+	{
+		// 0.5 is the edge of the glyph. Smooth over about one screen pixel, whatever the text size is.
+		float dist = texture(u_texture, uv).a;
+		float width = max(fwidth(dist) * 0.75, 0.0001);
+		color = vec4(v_color, smoothstep(0.5 - width, 0.5 + width, dist) * u_opacity);
+		alpha.xyz = vec3(1);
+		alpha.w = color.w;
+		return;
+	}
+	// The sample offset is relative to a 3000 pixel atlas.
+	vec2 offset = (1.5 / transform.z) / u_screenRes * (3000.0 / atlasSize);
 	for (int x = -NUM_SAMPLES; x < NUM_SAMPLES; x++)
 	{
 		for (int y = -NUM_SAMPLES; y < NUM_SAMPLES; y++)
 		{
-			sampled += texture(u_texture, TexCoords + offset * vec2(x, y)).a;
+			sampled += texture(u_texture, uv + offset * vec2(x, y)).a;
 		}
 	}
 	sampled /= float(NUM_SAMPLES) * float(NUM_SAMPLES) * 2.0 * 2.0;
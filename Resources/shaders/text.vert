@@ -1,19 +1,37 @@
 //! #version 330
-layout (location = 0) in vec2 vertex;
-layout (location = 1) in vec2 texcoords;// <vec2 pos, vec2 tex>
-layout (location = 2) in vec3 color;
+// One instance per glyph. The quad is expanded from the glyph's metrics in u_glyphs.
+layout (location = 0) in ivec2 i_position;
+layout (location = 1) in uint i_slot;
+layout (location = 2) in vec4 i_color;
 out vec2 TexCoords;
 out vec2 v_position;
 out vec3 v_color;
 uniform vec3 u_offset; // X = Y offset; Y = MaxDistance; Z MinDistance
 uniform vec3 transform;
 uniform float u_aspectratio;
+uniform vec2 u_origin;
+// Two texels per atlas slot: xy = texture coordinates, zw = texture size (in atlas pixels); xy = offset, zw = size (in font units)
+// Every row contains the metrics of 256 slots.
+uniform sampler2D u_glyphs;
+
+const vec2 corners[6] = vec2[6](
+	vec2(0, 1), vec2(1, 1), vec2(1, 0),
+	vec2(0, 0), vec2(0, 1), vec2(1, 0)
+);
+
 void main()
 {
+	ivec2 metrics = ivec2(int(i_slot % 256u) * 2, int(i_slot / 256u));
+	vec4 tex = texelFetch(u_glyphs, metrics, 0);
+	vec4 quad = texelFetch(u_glyphs, metrics + ivec2(1, 0), 0);
+	vec2 corner = corners[gl_VertexID];
+
+	// Instance positions are stored in 1/16 font units.
+	vec2 vertex = u_origin + vec2(i_position) / 16.0 + quad.xy + quad.zw * corner;
 	vec2 pos = vertex * transform.z;
 	pos += transform.xy;
 	gl_Position = (vec4(pos / 450.0 / vec2(u_aspectratio, -1), 0.0, 1.0)) + vec4(0, -u_offset.x, 0.0, 0.0);
 	v_position = gl_Position.xy;
-	TexCoords = texcoords;
-	v_color = color;
+	TexCoords = tex.xy + tex.zw * corner;
+	v_color = i_color.rgb;
 }
\ No newline at end of file
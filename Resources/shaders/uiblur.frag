@@ -5,31 +5,35 @@ in vec2 v_texCoords;
 out vec4 f_color;
 
 uniform sampler2D u_background;
-uniform vec2 u_scale;
-uniform vec2 u_position;
-uniform bool u_horizontal;
-
-const float weight[5] = float[] (0.227027, 0.1945946, 0.1216216, 0.054054, 0.016216);
+uniform bool u_upsample;
 
+// Dual filtering (Kawase) blur.
+// Downsampling averages the center and the 4 diagonal neighbors into a texture with half the size.
+// Upsampling spreads 8 samples around the center into a texture with twice the size.
 void main()
 {
-	vec2 tex_offset = vec2(1.0) / vec2(textureSize(u_background, 0)); // gets size of single texel
-	f_color.xyz = texture(u_background, v_texCoords).rgb * weight[0]; // current fragment's contribution
-	f_color.w = 1.0;
-	if (u_horizontal)
+	vec2 halfPixel = vec2(0.5) / vec2(textureSize(u_background, 0));
+	vec3 sum;
+	if (u_upsample)
 	{
-		for(int i = 1; i < 5; ++i)
-		{
-			f_color.xyz += texture(u_background, v_texCoords + vec2(tex_offset.x * float(i), 0.0)).rgb * weight[i];
-			f_color.xyz += texture(u_background, v_texCoords - vec2(tex_offset.x * float(i), 0.0)).rgb * weight[i];
-		}
+		sum = texture(u_background, v_texCoords + vec2(-halfPixel.x * 2.0, 0.0)).rgb;
+		sum += texture(u_background, v_texCoords + vec2(halfPixel.x * 2.0, 0.0)).rgb;
+		sum += texture(u_background, v_texCoords + vec2(0.0, -halfPixel.y * 2.0)).rgb;
+		sum += texture(u_background, v_texCoords + vec2(0.0, halfPixel.y * 2.0)).rgb;
+		sum += texture(u_background, v_texCoords + vec2(-halfPixel.x, halfPixel.y)).rgb * 2.0;
+		sum += texture(u_background, v_texCoords + vec2(halfPixel.x, halfPixel.y)).rgb * 2.0;
+		sum += texture(u_background, v_texCoords + vec2(halfPixel.x, -halfPixel.y)).rgb * 2.0;
+		sum += texture(u_background, v_texCoords + vec2(-halfPixel.x, -halfPixel.y)).rgb * 2.0;
+		sum /= 12.0;
 	}
 	else
 	{
-		for (int i = 1; i < 5; ++i)
-		{
-			f_color.xyz += texture(u_background, v_texCoords + vec2(0.0, tex_offset.y * float(i))).rgb * weight[i];
-			f_color.xyz += texture(u_background, v_texCoords - vec2(0.0, tex_offset.y * float(i))).rgb * weight[i];
-		}
+		sum = texture(u_background, v_texCoords).rgb * 4.0;
+		sum += texture(u_background, v_texCoords - halfPixel).rgb;
+		sum += texture(u_background, v_texCoords + halfPixel).rgb;
+		sum += texture(u_background, v_texCoords + vec2(halfPixel.x, -halfPixel.y)).rgb;
+		sum += texture(u_background, v_texCoords - vec2(halfPixel.x, -halfPixel.y)).rgb;
+		sum /= 8.0;
 	}
-}
\ No newline at end of file
+	f_color = vec4(sum, 1.0);
+}
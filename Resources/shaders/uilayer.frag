@@ -0,0 +1,14 @@
+//! #version 330
+
+in vec2 v_texcoords;
+layout (location = 0) out vec4 f_color;
+layout (location = 1) out vec4 f_alpha;
+
+uniform sampler2D u_layer;
+
+void main()
+{
+	// The layer has premultiplied colors.
+	f_color = texture(u_layer, v_texcoords);
+	f_alpha = vec4(f_color.w);
+}
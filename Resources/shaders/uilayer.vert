@@ -0,0 +1,11 @@
+//! #version 330
+
+out vec2 v_texcoords;
+
+uniform vec4 u_transform; // xy = bottom left corner, zw = top right corner
+
+void main()
+{
+	v_texcoords = vec2(float(gl_VertexID & 1), float((gl_VertexID >> 1) & 1));
+	gl_Position = vec4(mix(u_transform.xy, u_transform.zw, v_texcoords), 0.0, 1.0);
+}
@@ -6,43 +6,45 @@ in float v_cornerIndex;
 layout (location = 0) out vec4 f_color;
 layout (location = 1) out vec4 f_alpha;
 
-uniform vec3 u_color;
-uniform vec3 u_borderColor;
+// Values of the drawn box, either from uniforms or from the instance data of a batch. See uishader.vert.
+flat in vec4 v_transform;
+flat in vec3 v_offset; // Scroll bar: X = scrolled distance; Y = MaxDistance; Z MinDistance
+flat in vec3 v_color;
+flat in float v_opacity;
+flat in vec3 v_borderColor;
+flat in float v_borderScale;
+flat in float v_cornerScale;
+flat in int v_drawBorder;
+flat in int v_drawCorner;
+flat in int v_cornerFlags;
+flat in int v_borderFlags;
+
 uniform int u_useTexture;
 uniform sampler2D u_texture;
-uniform vec3 u_offset; // Scroll bar: X = scrolled distance; Y = MaxDistance; Z MinDistance
-uniform float u_opacity;
-uniform bool u_drawBorder;
-uniform bool u_drawCorner;
-uniform float u_borderScale;
-uniform float u_cornerScale;
-uniform vec4 u_transform;
 uniform float u_aspectRatio;
 uniform vec2 u_screenRes;
-uniform int u_cornerFlags;
-uniform int u_borderFlags;
 
 #define NUM_SAMPLES 2
 
 bool isBorderVisible(int index)
 {
-	return (u_borderFlags & (1 << index)) != 0;
+	return (v_borderFlags & (1 << index)) != 0;
 }
 
 void main()
 {
-	vec2 scale = u_transform.zw * vec2(u_aspectRatio, 1.0);
+	vec2 scale = v_transform.zw * vec2(u_aspectRatio, 1.0);
 	vec2 scaledTexCoords = v_texcoords * scale + (0.025 / u_screenRes);
 	vec2 nonAbsCenteredTexCoords = (scaledTexCoords - scale / 2.0) * 2.0;
 	vec2 centeredTexCoords = abs(nonAbsCenteredTexCoords);
 	
 	int cornerIndex = int(round(v_cornerIndex));
 	
-	if (u_offset.y > v_position.y)
+	if (v_offset.y > v_position.y)
 	{
 		discard;
 	}
-	if (u_offset.z < v_position.y)
+	if (v_offset.z < v_position.y)
 	{
 		discard;
 	}
@@ -66,44 +68,44 @@ void main()
 		}
 		sampled.xyz /= float(samples);
 		sampled.w /= float(NUM_SAMPLES * NUM_SAMPLES) * 2.0 * 2.0;
-		f_color = vec4(clamp(u_color * sampled.rgb, vec3(0.0), vec3(1.0)), u_opacity);
+		f_color = vec4(clamp(v_color * sampled.rgb, vec3(0.0), vec3(1.0)), v_opacity);
 		f_color.a *= sampled.w;
 	}
 	else
 	{
-		f_color = vec4(u_color, u_opacity);
+		f_color = vec4(v_color, v_opacity);
 	}
 
-	if (u_drawCorner && (u_cornerFlags & (1 << cornerIndex)) != 0
-		&& (centeredTexCoords.y >= scale.y - u_cornerScale) && (centeredTexCoords.x >= scale.x - u_cornerScale))
+	if (v_drawCorner != 0 && (v_cornerFlags & (1 << cornerIndex)) != 0
+		&& (centeredTexCoords.y >= scale.y - v_cornerScale) && (centeredTexCoords.x >= scale.x - v_cornerScale))
 	{
-		float borderSize = pow((length((scale - u_cornerScale) - centeredTexCoords) / u_cornerScale), u_cornerScale * 1000.0);
+		float borderSize = pow((length((scale - v_cornerScale) - centeredTexCoords) / v_cornerScale), v_cornerScale * 1000.0);
 		f_color.a *= clamp(1.0 / borderSize, 0.0, 1.0);
 
-		if (u_drawBorder && u_cornerScale > u_borderScale)
+		if (v_drawBorder != 0 && v_cornerScale > v_borderScale)
 		{
-			float cornerDistance = (length((scale - u_cornerScale) - centeredTexCoords));
-			f_color.rgb = mix(f_color.rgb, u_borderColor, clamp((u_borderScale - (u_cornerScale - cornerDistance)) / u_borderScale * 4.0, 0.0, 1.0));
+			float cornerDistance = (length((scale - v_cornerScale) - centeredTexCoords));
+			f_color.rgb = mix(f_color.rgb, v_borderColor, clamp((v_borderScale - (v_cornerScale - cornerDistance)) / v_borderScale * 4.0, 0.0, 1.0));
 		}
 	}
 
-	if (u_drawBorder)
+	if (v_drawBorder != 0)
 	{
-		if ((nonAbsCenteredTexCoords.x >= scale.x - u_borderScale) && isBorderVisible(0))
+		if ((nonAbsCenteredTexCoords.x >= scale.x - v_borderScale) && isBorderVisible(0))
 		{
-			f_color.rgb = u_borderColor;
+			f_color.rgb = v_borderColor;
 		}
-		else if ((nonAbsCenteredTexCoords.x <= -scale.x + u_borderScale) && isBorderVisible(1))
+		else if ((nonAbsCenteredTexCoords.x <= -scale.x + v_borderScale) && isBorderVisible(1))
 		{
-			f_color.rgb = u_borderColor;
+			f_color.rgb = v_borderColor;
 		}
-		else if ((nonAbsCenteredTexCoords.y >= scale.y - u_borderScale) && isBorderVisible(2))
+		else if ((nonAbsCenteredTexCoords.y >= scale.y - v_borderScale) && isBorderVisible(2))
 		{
-			f_color.rgb = u_borderColor;
+			f_color.rgb = v_borderColor;
 		}
-		else if ((nonAbsCenteredTexCoords.y <= -scale.y + u_borderScale) && isBorderVisible(3))
+		else if ((nonAbsCenteredTexCoords.y <= -scale.y + v_borderScale) && isBorderVisible(3))
 		{
-			f_color.rgb = u_borderColor;
+			f_color.rgb = v_borderColor;
 		}
 	}
 	f_alpha.xyz = vec3(1.0);
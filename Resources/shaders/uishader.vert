@@ -2,18 +2,78 @@
 
 layout(location = 0) in vec2 a_position;
 layout(location = 1) in float a_cornerIndex;
+
+// Per-instance values of batched backgrounds. Only used if u_instanced is true.
+layout(location = 2) in vec4 a_transform;
+layout(location = 3) in vec4 a_color; // xyz = color, w = opacity
+layout(location = 4) in vec4 a_borderColor; // xyz = border color, w = border scale
+layout(location = 5) in vec4 a_offset; // xyz = scroll offset, w = corner scale
+layout(location = 6) in vec4 a_flags; // x = draw border, y = draw corner, z = corner flags, w = border flags
+
+uniform bool u_instanced;
 uniform vec3 u_offset; //X = Y offset; Y = MaxDistance
 uniform vec4 u_transform; // xy = position zw = scale
 uniform vec2 u_screenRes;
+uniform vec3 u_color;
+uniform vec3 u_borderColor;
+uniform float u_opacity;
+uniform bool u_drawBorder;
+uniform bool u_drawCorner;
+uniform float u_borderScale;
+uniform float u_cornerScale;
+uniform int u_cornerFlags;
+uniform int u_borderFlags;
+
 out vec2 v_position;
 out vec2 v_texcoords;
 out float v_cornerIndex;
 
+flat out vec4 v_transform;
+flat out vec3 v_offset;
+flat out vec3 v_color;
+flat out float v_opacity;
+flat out vec3 v_borderColor;
+flat out float v_borderScale;
+flat out float v_cornerScale;
+flat out int v_drawBorder;
+flat out int v_drawCorner;
+flat out int v_cornerFlags;
+flat out int v_borderFlags;
+
 void main()
 {
+	if (u_instanced)
+	{
+		v_transform = a_transform;
+		v_offset = a_offset.xyz;
+		v_color = a_color.xyz;
+		v_opacity = a_color.w;
+		v_borderColor = a_borderColor.xyz;
+		v_borderScale = a_borderColor.w;
+		v_cornerScale = a_offset.w;
+		v_drawBorder = int(a_flags.x);
+		v_drawCorner = int(a_flags.y);
+		v_cornerFlags = int(a_flags.z);
+		v_borderFlags = int(a_flags.w);
+	}
+	else
+	{
+		v_transform = u_transform;
+		v_offset = u_offset;
+		v_color = u_color;
+		v_opacity = u_opacity;
+		v_borderColor = u_borderColor;
+		v_borderScale = u_borderScale;
+		v_cornerScale = u_cornerScale;
+		v_drawBorder = int(u_drawBorder);
+		v_drawCorner = int(u_drawCorner);
+		v_cornerFlags = u_cornerFlags;
+		v_borderFlags = u_borderFlags;
+	}
+
 	v_texcoords = a_position;
-	vec2 pixelPos = (v_texcoords * u_transform.zw + vec2(0, -u_offset.x) + u_transform.xy);
+	vec2 pixelPos = (v_texcoords * v_transform.zw + vec2(0, -v_offset.x) + v_transform.xy);
 	gl_Position = vec4(pixelPos, 0, 1);
 	v_position = gl_Position.xy;
 	v_cornerIndex = a_cornerIndex;
-}
\ No newline at end of file
+}
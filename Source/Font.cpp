@@ -1,4 +1,5 @@
 #include <kui/Font.h>
+#include <kui/TextLayout.h>
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "Util/stb_truetype.hpp"
 #include <kui/Rendering/Shader.h>
@@ -9,530 +10,1129 @@
 #include <kui/Resource.h>
 #include "Internal/OpenGL.h"
 #include <kui/Window.h>
-#include "Internal/Internal.h"
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <filesystem>
 using namespace kui;
 
 
-constexpr int FONT_BITMAP_WIDTH = 3000;
-constexpr int FONT_BITMAP_PADDING = 32;
-constexpr int FONT_MAX_UNICODE_CHARS = 800;
+constexpr float FONT_GLYPH_SCALE = 0.05f;
+constexpr int FONT_ATLAS_INITIAL_SIZE = 512;
+constexpr int FONT_ATLAS_PADDING = 16;
+// Distance fields are rendered at half the scale of normal glyphs, since they can be magnified without getting blurry.
+constexpr float FONT_SDF_SCALE = 0.025f;
+// Number of pixels around an SDF glyph that contain distance values.
+constexpr int FONT_SDF_PADDING = 4;
+constexpr uint8_t FONT_SDF_EDGE_VALUE = 128;
+// The number of lines in each vertex buffer of a DrawableText.
+constexpr size_t FONT_LINES_PER_BLOCK = 32;
+// Instance positions are stored in fixed point with this many steps per font unit.
+constexpr float FONT_INSTANCE_POSITION_STEPS = 16.0f;
+// Slot indices are 16 bit, the last one is never used.
+constexpr size_t FONT_MAX_ATLAS_SLOTS = UINT16_MAX;
+// The number of atlas slots in every row of the glyph metrics texture. Must match text.vert.
+constexpr size_t GlyphMetricsRowSlots = 256;
+// Kerning pairs are looked up in a fixed number of probes, so the table is kept at most half full.
+constexpr size_t FONT_KERNING_LOAD_FACTOR = 2;
+// Glyphs that are rendered while loading the font, so the first texts don't have to wait for them.
+constexpr char32_t FONT_PRELOAD_FIRST_CHAR = 32;
+constexpr char32_t FONT_PRELOAD_LAST_CHAR = 126;
+// Increment when the layout of the atlas cache files changes.
+constexpr uint32_t FONT_CACHE_VERSION = 1;
+constexpr char FONT_CACHE_MAGIC[4] = { 'K', 'U', 'I', 'A' };
+// The line height is calculated from the characters up to this one.
+constexpr int FONT_LINE_HEIGHT_LAST_CHAR = 801;
 
 const std::string TextShaderName = "TextShader";
 
+std::string Font::AtlasCacheDirectory;
+
+/*
+* Layout of an atlas cache file. All parts are plain data with 4 byte alignment, so the file can be used in place:
+* AtlasCacheHeader, NumGlyphs * AtlasCacheGlyph, NumShelves * AtlasCacheShelf, AtlasSize * AtlasSize bytes of pixels.
+*/
+struct AtlasCacheHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t HeaderSize;
+	uint32_t GlyphSize;
+	uint64_t FontHash;
+	float GlyphScale;
+	int32_t Padding;
+	uint32_t SDF;
+	int32_t AtlasSize;
+	uint32_t NumGlyphs;
+	uint32_t NumShelves;
+	uint32_t NumSlots;
+	uint32_t Reserved;
+};
+
+struct AtlasCacheGlyph
+{
+	uint32_t Character;
+	int32_t GlyphIndex;
+	float Size[2];
+	float Offset[2];
+	float TotalSize[2];
+	float TexCoordStart[2];
+	float TexCoordOffset[2];
+	int32_t SlotX, SlotY, SlotWidth, SlotHeight;
+	uint32_t SlotIndex;
+};
+
+struct AtlasCacheShelf
+{
+	int32_t Y, Height, UsedWidth;
+};
+
+static uint64_t HashFontData(const uint8_t* Data, size_t Length)
+{
+	// 64 bit FNV-1a
+	uint64_t Hash = 0xCBF29CE484222325ull;
+	for (size_t i = 0; i < Length; i++)
+	{
+		Hash ^= Data[i];
+		Hash *= 0x100000001B3ull;
+	}
+	return Hash;
+}
+
 Shader* Font::GetTextShader()
 {
 	return Window::GetActiveWindow()->Shaders.GetShader(TextShaderName);
 }
 
-static void ReplaceTabs(std::vector<TextSegment>& Text, size_t TabSize, char ReplaceWith = ' ')
+size_t Font::GetCharacterAtPosition(const std::vector<TextSegment>& Text, Vec2f Position, float Scale, bool Wrapped, float LengthBeforeWrap, uint32_t MaxLines)
+{
+	TextLayout Layout;
+	Layout.Update(this, Text, Scale, Wrapped, LengthBeforeWrap, MaxLines);
+	return Layout.GetCharacterAtPosition(Position);
+}
+
+Font::Font(std::string FileName, bool LoadAsync)
 {
-	size_t CharIndex = 0;
-	for (auto& i : Text)
+	Window::GetActiveWindow()->Shaders.LoadShader("res:shaders/text.vert", "res:shaders/text.frag", TextShaderName);
+	CacheDirectory = AtlasCacheDirectory;
+
+	// Glyphs are only uploaded once they are used, so the GL objects can be created before the font is loaded.
+	glGenTextures(1, &fontTexture);
+	ResizeAtlas(FONT_ATLAS_INITIAL_SIZE);
+
+	glGenTextures(1, &GlyphMetricsTexture);
+
+#ifdef KLEMMUI_WEB_BUILD
+	// Web builds don't use threads.
+	LoadAsync = false;
+#endif
+	if (LoadAsync)
 	{
-		for (size_t it = 0; it < i.Text.size(); it++)
-		{
-			if (i.Text[it] == '\t')
-			{
-				i.Text[it] = ' ';
-				while (++CharIndex % TabSize)
-				{
-					i.Text.insert(i.Text.begin() + it++, ' ');
-				}
-			}
-			else
-			{
-				CharIndex++;
-			}
-		}
+		LoadThread = std::thread(&Font::LoadFile, this, FileName);
+	}
+	else
+	{
+		LoadFile(FileName);
+		FinishLoading();
 	}
-
 }
 
-size_t Font::GetCharacterAtPosition(std::vector<TextSegment> Text, Vec2f Position, float Scale, bool Wrapped, float LengthBeforeWrap, uint32_t MaxLines)
+void Font::LoadFile(std::string FileName)
 {
-	float MaxHeight = 0.0f;
-	float x = 0.f, y = 0;
-	size_t i = 0;
-	size_t CharIndex = 0;
-	size_t Nearest = SIZE_MAX;
-	float NearestVerticalDist = INFINITY;
-	float LastVerticalDist = INFINITY;
-	LengthBeforeWrap = LengthBeforeWrap * Window::GetActiveWindow()->GetAspectRatio() / Scale;
-	uint32_t CurrentLine = 0;
+	if (!resource::FileExists(FileName))
+	{
+		LoadError = "Failed to find font resource: " + FileName;
+		LoadThreadDone = true;
+		return;
+	}
+
+	resource::BinaryData TextData = resource::GetBinaryFile(FileName);
+	FontFile = new resource::BinaryData(TextData);
+
+	FontInfo = new stbtt_fontinfo();
+	stbtt_InitFont(FontInfo, FontFile->Data, stbtt_GetFontOffsetForIndex(FontFile->Data, 0));
+
+	bool HasCache = false;
+	if (!CacheDirectory.empty())
+	{
+		FontHash = HashFontData(FontFile->Data, FontFile->FileSize);
+		HasCache = ReadAtlasCache(LoadedCacheData);
+	}
 
-	for (auto& seg : Text)
+	// The work is split into ranges of characters, one for each thread.
+	// stbtt only reads from the font info, so it can be used by multiple threads at once.
+#ifdef KLEMMUI_WEB_BUILD
+	size_t NumThreads = 1;
+#else
+	size_t NumThreads = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, 8);
+#endif
+	std::vector<std::thread> Workers;
+	std::vector<float> LineHeights = std::vector<float>(NumThreads, 0.0f);
+	std::vector<std::vector<std::pair<char32_t, PreloadedBitmap>>> Bitmaps = std::vector<std::vector<std::pair<char32_t, PreloadedBitmap>>>(NumThreads);
+
+	auto LoadRange = [this, NumThreads, HasCache, &LineHeights, &Bitmaps](size_t Thread)
 	{
-		size_t LastWordIndex = SIZE_MAX;
-		size_t LastWrapIndex = 0;
-		std::u32string SegmentText = internal::GetUnicodeString(seg.Text, true);
-		bool FoundInCurrentLine = false;
-		for (size_t i = 0; i < SegmentText.size(); i++, CharIndex++)
+		// Only the bounding boxes are needed for the line height.
+		for (int i = 32 + int(Thread); i <= FONT_LINE_HEIGHT_LAST_CHAR; i += int(NumThreads))
 		{
-			if (CurrentLine > MaxLines)
-			{
-				break;
-			}
-			float CharSize = 0;
-			bool IsTab = SegmentText[i] == int('\t');
-			if (IsTab)
-			{
-				IsTab = true;
-				SegmentText[i] = ' ';
-			}
-			if (SegmentText[i] < 32)
-			{
-				if (SegmentText[i] == int('\n'))
-				{
-					LastVerticalDist = -Position.Y - (y + CharacterSize / 2) / 450 * Scale;
-					x = 0;
-					y += CharacterSize;
-					CurrentLine++;
-
-					FoundInCurrentLine = false;
-				}
-			}
-			else
+			int x0, y0, x1, y1;
+			stbtt_GetCodepointBitmapBox(FontInfo, i, FONT_GLYPH_SCALE, FONT_GLYPH_SCALE, &x0, &y0, &x1, &y1);
+			LineHeights[Thread] = std::max(float(y1 - y0) / 20.0f + std::max(float(y0) / 20.0f, 0.0f), LineHeights[Thread]);
+		}
+		// The cached atlas already contains the rendered glyphs.
+		for (char32_t c = FONT_PRELOAD_FIRST_CHAR + char32_t(Thread); !HasCache && c <= FONT_PRELOAD_LAST_CHAR; c += char32_t(NumThreads))
+		{
+			PreloadedBitmap New;
+			uint8_t* Bitmap = stbtt_GetCodepointBitmap(FontInfo,
+				FONT_GLYPH_SCALE,
+				FONT_GLYPH_SCALE,
+				int(c),
+				&New.Width,
+				&New.Height,
+				&New.OffsetX,
+				&New.OffsetY);
+			if (Bitmap)
 			{
-				int GlyphIndex = (int)SegmentText[i] - 32;
-				if (GlyphIndex < 0)
-				{
-					continue;
-				}
-				if (GlyphIndex > LoadedGlyphs.size())
-				{
-					GlyphIndex = int(LoadedGlyphs.size() - 1);
-				}
-
-				Glyph g = LoadedGlyphs[GlyphIndex];
-
-				if (IsTab)
-				{
-					int Multiplier = (TabSize - CharIndex % TabSize);
-					g.TotalSize.X *= Multiplier;
-					CharIndex += Multiplier - 1;
-				}
-
-				if (SegmentText[i] == ' ')
-				{
-					LastWordIndex = i;
-				}
-
-				if (((x + g.TotalSize.X) / 450 > LengthBeforeWrap && Wrapped))
-				{
-					x = 0;
-					y += CharacterSize;
-					if (LastWordIndex != SIZE_MAX && LastWordIndex != LastWrapIndex)
-					{
-						i = LastWordIndex;
-						LastWrapIndex = i;
-						if (Nearest > i)
-						{
-							Nearest = SIZE_MAX;
-						}
-						continue;
-					}
-					LastVerticalDist = -Position.Y - (y + CharacterSize / 2) / 450 * Scale;
-					CurrentLine++;
-
-					FoundInCurrentLine = false;
-					if (CurrentLine > MaxLines)
-					{
-						break;
-					}
-				}
-
-				x += g.TotalSize.X;
-				CharSize = g.TotalSize.X;
+				New.Pixels.assign(Bitmap, Bitmap + size_t(New.Width) * New.Height);
+				stbtt_FreeBitmap(Bitmap, nullptr);
+				Bitmaps[Thread].push_back({ c, std::move(New) });
 			}
-			float CurrentDistance = x / 450 / Window::GetActiveWindow()->GetAspectRatio() * Scale;
-			float VerticalDist = -Position.Y - (y + CharacterSize / 2) / 450 * Scale;
+		}
+	};
 
-			if (std::abs(LastVerticalDist) < std::abs(VerticalDist) && Nearest == SIZE_MAX)
-			{
-				return i;
-			}
-			bool IsOnCurrentLine = false;
-			if (std::abs(VerticalDist) < std::abs(NearestVerticalDist))
-			{
-				Nearest = SIZE_MAX;
-				IsOnCurrentLine = true;
-			}
+	for (size_t i = 1; i < NumThreads; i++)
+	{
+		Workers.push_back(std::thread(LoadRange, i));
+	}
+	LoadRange(0);
+	LoadKerningTable();
+	for (std::thread& Worker : Workers)
+	{
+		Worker.join();
+	}
 
-			if (CurrentDistance > Position.X && !FoundInCurrentLine && IsOnCurrentLine)
-			{
-				if (CurrentDistance > Position.X + (CharSize / 800 / Window::GetActiveWindow()->GetAspectRatio() * Scale))
-				{
-					Nearest = std::min(i, TextSegment::CombineToString(Text).size());
-				}
-				else
-				{
-					Nearest = std::min(i + 1, TextSegment::CombineToString(Text).size());
-				}
-				FoundInCurrentLine = true;
-				NearestVerticalDist = VerticalDist;
-			}
+	for (size_t i = 0; i < NumThreads; i++)
+	{
+		CharacterSize = std::max(CharacterSize, LineHeights[i]);
+		for (auto& [Character, Bitmap] : Bitmaps[i])
+		{
+			PreloadedBitmaps.insert({ Character, std::move(Bitmap) });
 		}
 	}
+	LoadThreadDone = true;
+}
 
-	return std::min(Nearest, TextSegment::CombineToString(Text).size());
+void Font::FinishLoading()
+{
+	if (LoadThread.joinable())
+	{
+		LoadThread.join();
+	}
+	Loaded = true;
+	if (!LoadError.empty())
+	{
+		app::error::Error(LoadError);
+		LoadError.clear();
+	}
+	if (!LoadedCacheData.empty())
+	{
+		ApplyAtlasCache(LoadedCacheData);
+		LoadedCacheData.clear();
+		LoadedCacheData.shrink_to_fit();
+	}
 }
 
-Font::Font(std::string FileName)
+std::string Font::GetAtlasCachePath() const
 {
-	Window::GetActiveWindow()->Shaders.LoadShader("res:shaders/text.vert", "res:shaders/text.frag", TextShaderName);
+	char HashString[17];
+	snprintf(HashString, sizeof(HashString), "%016llx", (unsigned long long)FontHash);
+	return (std::filesystem::path(CacheDirectory) / (std::string(HashString) + (UseSDF ? "_sdf" : "") + ".kuiatlas")).string();
+}
 
-	if (!resource::FileExists(FileName))
+bool Font::ReadAtlasCache(std::vector<uint8_t>& OutData) const
+{
+	std::ifstream In = std::ifstream(GetAtlasCachePath(), std::ios::binary | std::ios::ate);
+	if (!In.is_open())
 	{
-		app::error::Error("Failed to find font resource: " + FileName);
-		return;
+		return false;
 	}
+	size_t Length = size_t(In.tellg());
+	if (Length < sizeof(AtlasCacheHeader))
+	{
+		return false;
+	}
+	OutData.resize(Length);
+	In.seekg(0);
+	In.read((char*)OutData.data(), std::streamsize(Length));
+	if (!In)
+	{
+		OutData.clear();
+		return false;
+	}
+	return true;
+}
 
-	resource::BinaryData TextData = resource::GetBinaryFile(FileName);
-
-	stbtt_fontinfo finf;
-	stbtt_InitFont(&finf, TextData.Data, stbtt_GetFontOffsetForIndex(TextData.Data, 0));
+bool Font::ApplyAtlasCache(const std::vector<uint8_t>& Data)
+{
+	if (Data.size() < sizeof(AtlasCacheHeader))
+	{
+		return false;
+	}
+	AtlasCacheHeader Header;
+	memcpy(&Header, Data.data(), sizeof(Header));
+
+	// Any difference in the rendering parameters makes the cache unusable.
+	if (memcmp(Header.Magic, FONT_CACHE_MAGIC, sizeof(Header.Magic)) != 0
+		|| Header.Version != FONT_CACHE_VERSION
+		|| Header.HeaderSize != sizeof(AtlasCacheHeader)
+		|| Header.GlyphSize != sizeof(AtlasCacheGlyph)
+		|| Header.FontHash != FontHash
+		|| Header.GlyphScale != (UseSDF ? FONT_SDF_SCALE : FONT_GLYPH_SCALE)
+		|| Header.Padding != (UseSDF ? FONT_SDF_PADDING : FONT_ATLAS_PADDING)
+		|| Header.SDF != uint32_t(UseSDF)
+		|| Header.AtlasSize < FONT_ATLAS_INITIAL_SIZE
+		|| Header.NumSlots > FONT_MAX_ATLAS_SLOTS)
+	{
+		return false;
+	}
+	size_t ExpectedSize = sizeof(AtlasCacheHeader)
+		+ sizeof(AtlasCacheGlyph) * size_t(Header.NumGlyphs)
+		+ sizeof(AtlasCacheShelf) * size_t(Header.NumShelves)
+		+ size_t(Header.AtlasSize) * size_t(Header.AtlasSize);
+	if (Data.size() != ExpectedSize)
+	{
+		return false;
+	}
 
+	const uint8_t* Position = Data.data() + sizeof(AtlasCacheHeader);
+	std::vector<AtlasCacheGlyph> CachedGlyphs = std::vector<AtlasCacheGlyph>(Header.NumGlyphs);
+	memcpy(CachedGlyphs.data(), Position, sizeof(AtlasCacheGlyph) * CachedGlyphs.size());
+	Position += sizeof(AtlasCacheGlyph) * CachedGlyphs.size();
+	std::vector<AtlasCacheShelf> CachedShelves = std::vector<AtlasCacheShelf>(Header.NumShelves);
+	memcpy(CachedShelves.data(), Position, sizeof(AtlasCacheShelf) * CachedShelves.size());
+	Position += sizeof(AtlasCacheShelf) * CachedShelves.size();
+
+	// The cache file is untrusted, so slots and shelves outside of the atlas reject the whole cache.
+	// Sums are calculated with 64 bits so large values can't overflow into the valid range.
+	for (const AtlasCacheGlyph& Cached : CachedGlyphs)
+	{
+		if (Cached.SlotIndex >= Header.NumSlots
+			|| Cached.SlotX < 0 || Cached.SlotY < 0
+			|| Cached.SlotWidth < 0 || Cached.SlotHeight < 0
+			|| int64_t(Cached.SlotX) + Cached.SlotWidth > Header.AtlasSize
+			|| int64_t(Cached.SlotY) + Cached.SlotHeight > Header.AtlasSize)
+		{
+			return false;
+		}
+	}
 
-	uint8_t* GlypthBitmap = new uint8_t[FONT_BITMAP_WIDTH * FONT_BITMAP_WIDTH]();
-	int xcoord = 0;
-	int ycoord = 0;
-	int maxH = 0;
+	// AllocateAtlasSlot() places new shelves below the last one, so the shelves have to be sorted and can't overlap.
+	int64_t ShelvesEnd = 0;
+	for (const AtlasCacheShelf& Shelf : CachedShelves)
+	{
+		if (Shelf.Y < ShelvesEnd
+			|| Shelf.Height <= 0
+			|| Shelf.UsedWidth < 0 || Shelf.UsedWidth > Header.AtlasSize
+			|| int64_t(Shelf.Y) + Shelf.Height > Header.AtlasSize)
+		{
+			return false;
+		}
+		ShelvesEnd = int64_t(Shelf.Y) + Shelf.Height;
+	}
 
 	LoadedGlyphs.clear();
-
-	for (int i = 32; i <= FONT_MAX_UNICODE_CHARS + 1; i++)
+	AtlasShelves.clear();
+	for (const AtlasCacheShelf& Shelf : CachedShelves)
+	{
+		AtlasShelves.push_back(AtlasShelf{
+			.Y = Shelf.Y,
+			.Height = Shelf.Height,
+			.UsedWidth = Shelf.UsedWidth,
+			});
+	}
+	AtlasSlotCount = Header.NumSlots;
+	AtlasSize = Header.AtlasSize;
+	AtlasPixels.assign(Position, Position + size_t(AtlasSize) * size_t(AtlasSize));
+	AtlasOverBudget = false;
+	AtlasGeneration++;
+	UploadAtlas();
+
+	GlyphMetrics.assign(size_t(AtlasSlotCount) * 8, 0.0f);
+	for (const AtlasCacheGlyph& Cached : CachedGlyphs)
 	{
 		Glyph New;
-		int glyph = i;
-		int w, h, xoff, yoff;
-		auto bmp = stbtt_GetCodepointBitmap(&finf,
-			0.05f,
-			0.05f,
-			glyph,
-			&w,
-			&h,
-			&xoff,
-			&yoff);
+		New.GlyphIndex = Cached.GlyphIndex;
+		New.Size = Vec2f(Cached.Size[0], Cached.Size[1]);
+		New.Offset = Vec2f(Cached.Offset[0], Cached.Offset[1]);
+		New.TotalSize = Vec2f(Cached.TotalSize[0], Cached.TotalSize[1]);
+		New.TexCoordStart = Vec2f(Cached.TexCoordStart[0], Cached.TexCoordStart[1]);
+		New.TexCoordOffset = Vec2f(Cached.TexCoordOffset[0], Cached.TexCoordOffset[1]);
+		New.SlotX = Cached.SlotX;
+		New.SlotY = Cached.SlotY;
+		New.SlotWidth = Cached.SlotWidth;
+		New.SlotHeight = Cached.SlotHeight;
+		New.SlotIndex = uint16_t(Cached.SlotIndex);
+		New.Rasterized = true;
+
+		const float SlotMetrics[8] = {
+			New.TexCoordStart.X, New.TexCoordStart.Y, New.TexCoordOffset.X, New.TexCoordOffset.Y,
+			New.Offset.X, New.Offset.Y, New.Size.X, New.Size.Y,
+		};
+		memcpy(&GlyphMetrics[size_t(New.SlotIndex) * 8], SlotMetrics, sizeof(SlotMetrics));
+		LoadedGlyphs.insert({ char32_t(Cached.Character), New });
+	}
+	if (AtlasSlotCount > 0)
+	{
+		FirstChangedSlot = 0;
+		EndChangedSlot = AtlasSlotCount;
+	}
+	AtlasCacheOutdated = false;
+	return true;
+}
 
-		int advW, leftB;
-		stbtt_GetCodepointHMetrics(&finf, glyph, &advW, &leftB);
+bool Font::SaveAtlasCache()
+{
+	if (CacheDirectory.empty() || !Loaded || !FontFile || AtlasOverBudget)
+	{
+		return false;
+	}
 
-		New.TotalSize.X = (float)advW / 400.0f;
-		New.TotalSize.Y = 0;
+	AtlasCacheHeader Header;
+	memset(&Header, 0, sizeof(Header));
+	memcpy(Header.Magic, FONT_CACHE_MAGIC, sizeof(Header.Magic));
+	Header.Version = FONT_CACHE_VERSION;
+	Header.HeaderSize = sizeof(AtlasCacheHeader);
+	Header.GlyphSize = sizeof(AtlasCacheGlyph);
+	Header.FontHash = FontHash;
+	Header.GlyphScale = UseSDF ? FONT_SDF_SCALE : FONT_GLYPH_SCALE;
+	Header.Padding = UseSDF ? FONT_SDF_PADDING : FONT_ATLAS_PADDING;
+	Header.SDF = uint32_t(UseSDF);
+	Header.AtlasSize = AtlasSize;
+	Header.NumShelves = uint32_t(AtlasShelves.size());
+	Header.NumSlots = uint32_t(AtlasSlotCount);
+
+	std::vector<AtlasCacheGlyph> CachedGlyphs;
+	for (const auto& [Character, g] : LoadedGlyphs)
+	{
+		if (!g.Rasterized)
+		{
+			continue;
+		}
+		AtlasCacheGlyph& Cached = CachedGlyphs.emplace_back();
+		memset(&Cached, 0, sizeof(Cached));
+		Cached.Character = uint32_t(Character);
+		Cached.GlyphIndex = g.GlyphIndex;
+		Cached.Size[0] = g.Size.X;
+		Cached.Size[1] = g.Size.Y;
+		Cached.Offset[0] = g.Offset.X;
+		Cached.Offset[1] = g.Offset.Y;
+		Cached.TotalSize[0] = g.TotalSize.X;
+		Cached.TotalSize[1] = g.TotalSize.Y;
+		Cached.TexCoordStart[0] = g.TexCoordStart.X;
+		Cached.TexCoordStart[1] = g.TexCoordStart.Y;
+		Cached.TexCoordOffset[0] = g.TexCoordOffset.X;
+		Cached.TexCoordOffset[1] = g.TexCoordOffset.Y;
+		Cached.SlotX = g.SlotX;
+		Cached.SlotY = g.SlotY;
+		Cached.SlotWidth = g.SlotWidth;
+		Cached.SlotHeight = g.SlotHeight;
+		Cached.SlotIndex = g.SlotIndex;
+	}
+	Header.NumGlyphs = uint32_t(CachedGlyphs.size());
+
+	std::vector<AtlasCacheShelf> CachedShelves;
+	for (const AtlasShelf& Shelf : AtlasShelves)
+	{
+		CachedShelves.push_back(AtlasCacheShelf{ Shelf.Y, Shelf.Height, Shelf.UsedWidth });
+	}
 
-		if (xcoord + w + FONT_BITMAP_PADDING > FONT_BITMAP_WIDTH)
+	std::error_code Error;
+	std::filesystem::create_directories(CacheDirectory, Error);
+	std::string Path = GetAtlasCachePath();
+	// Written to a temporary file first, so other processes never read a partially written cache.
+	std::string TempPath = Path + ".tmp" + std::to_string(uintptr_t(this));
+	{
+		std::ofstream Out = std::ofstream(TempPath, std::ios::binary | std::ios::trunc);
+		if (!Out.is_open())
 		{
-			xcoord = 0;
-			ycoord += maxH + FONT_BITMAP_PADDING;
+			return false;
 		}
+		Out.write((const char*)&Header, sizeof(Header));
+		Out.write((const char*)CachedGlyphs.data(), std::streamsize(sizeof(AtlasCacheGlyph) * CachedGlyphs.size()));
+		Out.write((const char*)CachedShelves.data(), std::streamsize(sizeof(AtlasCacheShelf) * CachedShelves.size()));
+		Out.write((const char*)AtlasPixels.data(), std::streamsize(AtlasPixels.size()));
+		if (!Out)
+		{
+			Out.close();
+			std::filesystem::remove(TempPath, Error);
+			return false;
+		}
+	}
+	std::filesystem::rename(TempPath, Path, Error);
+	if (Error)
+	{
+		std::filesystem::remove(TempPath, Error);
+		return false;
+	}
+	AtlasCacheOutdated = false;
+	return true;
+}
+
+bool Font::IsLoaded()
+{
+	if (!Loaded && LoadThreadDone)
+	{
+		FinishLoading();
+	}
+	return Loaded;
+}
 
-		New.TexCoordStart = Vec2(
-			(float)xcoord / FONT_BITMAP_WIDTH,
-			(float)ycoord / FONT_BITMAP_WIDTH);
+void Font::WaitForLoading()
+{
+	if (!Loaded)
+	{
+		FinishLoading();
+	}
+}
 
-		New.TexCoordOffset = Vec2(
-			(float)(w + 3) / FONT_BITMAP_WIDTH,
-			(float)(h + 3) / FONT_BITMAP_WIDTH);
+Font::Glyph& Font::GetGlyph(char32_t Character)
+{
+	WaitForLoading();
+	auto Found = LoadedGlyphs.find(Character);
+	if (Found != LoadedGlyphs.end())
+	{
+		return Found->second;
+	}
 
-		New.Offset = Vec2f((float)xoff, (float)yoff) / 20.0;
-		New.Size = Vec2f((float)w, (float)h) / 20.0;
+	Glyph New;
+	if (FontInfo)
+	{
+		int advW, leftB;
+		stbtt_GetCodepointHMetrics(FontInfo, int(Character), &advW, &leftB);
+		int x0, y0, x1, y1;
+		stbtt_GetCodepointBitmapBox(FontInfo, int(Character), FONT_GLYPH_SCALE, FONT_GLYPH_SCALE, &x0, &y0, &x1, &y1);
 
-		CharacterSize = std::max(New.Size.Y + std::max(New.Offset.Y, 0.0f), CharacterSize);
+		New.GlyphIndex = stbtt_FindGlyphIndex(FontInfo, int(Character));
+		New.TotalSize.X = (float)advW / 400.0f;
+		New.TotalSize.Y = 0;
+		New.Offset = Vec2f((float)x0, (float)y0) / 20.0;
+		New.Size = Vec2f((float)(x1 - x0), (float)(y1 - y0)) / 20.0;
 
 		if (New.Size != 0)
 		{
 			// Give some additional space for better anti aliasing
 			New.Size += Vec2(3.0f / 20.0f, 3.0f / 20.0f);
 		}
+	}
+	return LoadedGlyphs.insert({ Character, New }).first->second;
+}
+
+static uint32_t HashKerningPair(uint32_t Key)
+{
+	Key ^= Key >> 16;
+	Key *= 0x7FEB352Du;
+	Key ^= Key >> 15;
+	return Key;
+}
 
-		if (w == 0 || h == 0 || i == ' ')
+void Font::LoadKerningTable()
+{
+	// stbtt_GetGlyphKernAdvance() reads both the GPOS and the legacy kern table. Most modern fonts only have GPOS kerning.
+	if (!FontInfo->gpos && !FontInfo->kern)
+	{
+		return;
+	}
+
+	// The pairs of the preloaded characters are looked up now, so laying out ASCII text never has to search the font's tables.
+	std::vector<int> GlyphIndices;
+	for (char32_t c = FONT_PRELOAD_FIRST_CHAR; c <= FONT_PRELOAD_LAST_CHAR; c++)
+	{
+		int Index = stbtt_FindGlyphIndex(FontInfo, int(c));
+		if (Index != 0)
 		{
-			New.TexCoordStart = 0;
-			New.TexCoordOffset = 0;
-			LoadedGlyphs.push_back(New);
-			continue;
+			GlyphIndices.push_back(Index);
 		}
+	}
+
+	size_t TableSize = 1;
+	while (TableSize < GlyphIndices.size() * GlyphIndices.size() * FONT_KERNING_LOAD_FACTOR)
+	{
+		TableSize *= 2;
+	}
+	KerningTable.assign(TableSize, KerningPair());
 
-		if (ycoord + h > 3000)
+	for (int First : GlyphIndices)
+	{
+		for (int Second : GlyphIndices)
 		{
-			break;
+			AddKerningPair(uint32_t(First) << 16 | uint32_t(Second),
+				float(stbtt_GetGlyphKernAdvance(FontInfo, First, Second)) / 400.0f);
 		}
+	}
+}
 
-		for (int ith = 0; ith < h; ith++)
+void Font::AddKerningPair(uint32_t Key, float Advance) const
+{
+	if ((KerningPairCount + 1) * FONT_KERNING_LOAD_FACTOR > KerningTable.size())
+	{
+		std::vector<KerningPair> OldTable = std::move(KerningTable);
+		KerningTable.assign(std::max(OldTable.size() * 2, size_t(1024)), KerningPair());
+		KerningPairCount = 0;
+		KerningMaxProbe = 0;
+		for (const KerningPair& Pair : OldTable)
 		{
-			for (int itw = 0; itw < w; itw++)
+			if (Pair.Key != UINT32_MAX)
 			{
-				GlypthBitmap[(ith + ycoord) * FONT_BITMAP_WIDTH + (xcoord + itw)] = bmp[ith * w + itw];
+				AddKerningPair(Pair.Key, Pair.Advance);
 			}
 		}
-		maxH = std::max(maxH, h);
-		xcoord += w + FONT_BITMAP_PADDING;
-		LoadedGlyphs.push_back(New);
-		free(bmp);
 	}
 
-	glGenTextures(1, &fontTexture);
+	uint32_t Mask = uint32_t(KerningTable.size() - 1);
+	uint32_t Slot = HashKerningPair(Key) & Mask;
+	uint32_t Distance = 0;
+	while (KerningTable[Slot].Key != UINT32_MAX && KerningTable[Slot].Key != Key)
+	{
+		Slot = (Slot + 1) & Mask;
+		Distance++;
+	}
+	if (KerningTable[Slot].Key != Key)
+	{
+		KerningPairCount++;
+	}
+	KerningTable[Slot].Key = Key;
+	KerningTable[Slot].Advance = Advance;
+	KerningMaxProbe = std::max(KerningMaxProbe, Distance + 1);
+}
+
+float Font::GetKerning(int FirstGlyphIndex, int SecondGlyphIndex) const
+{
+	// Glyph index 0 is the missing glyph, which has no kerning.
+	if (KerningTable.empty() || FirstGlyphIndex == 0 || SecondGlyphIndex == 0)
+	{
+		return 0;
+	}
+
+	// Always checks the same number of slots and selects the match without branching,
+	// which is faster than an early exit for the short probe sequences of a half full table.
+	uint32_t Key = uint32_t(FirstGlyphIndex) << 16 | (uint32_t(SecondGlyphIndex) & 0xFFFF);
+	uint32_t Mask = uint32_t(KerningTable.size() - 1);
+	uint32_t Slot = HashKerningPair(Key) & Mask;
+	float Result = 0;
+	bool Found = false;
+	for (uint32_t i = 0; i < KerningMaxProbe; i++)
+	{
+		const KerningPair& Pair = KerningTable[(Slot + i) & Mask];
+		bool Match = Pair.Key == Key;
+		Result += Match ? Pair.Advance : 0.0f;
+		Found |= Match;
+	}
+	if (!Found)
+	{
+		Result = float(stbtt_GetGlyphKernAdvance(FontInfo, FirstGlyphIndex, SecondGlyphIndex)) / 400.0f;
+		AddKerningPair(Key, Result);
+	}
+	return Result;
+}
+
+void Font::ResizeAtlas(int NewSize)
+{
+	// Existing glyphs keep their position, so texture coordinates (in pixels) stay valid.
+	std::vector<uint8_t> NewPixels = std::vector<uint8_t>(size_t(NewSize) * size_t(NewSize), 0);
+	for (int y = 0; y < AtlasSize; y++)
+	{
+		memcpy(&NewPixels[size_t(y) * NewSize], &AtlasPixels[size_t(y) * AtlasSize], AtlasSize);
+	}
+	AtlasPixels = std::move(NewPixels);
+	AtlasSize = NewSize;
+	UploadAtlas();
+}
+
+void Font::UploadAtlas()
+{
 	glBindTexture(GL_TEXTURE_2D, fontTexture);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 	glTexImage2D(GL_TEXTURE_2D,
 		0,
 		GL_ALPHA,
-		FONT_BITMAP_WIDTH,
-		FONT_BITMAP_WIDTH,
+		AtlasSize,
+		AtlasSize,
 		0,
 		GL_ALPHA,
 		GL_UNSIGNED_BYTE,
-		GlypthBitmap);
-	// can free temp_bitmap at this point
+		AtlasPixels.data());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glGenerateMipmap(GL_TEXTURE_2D);
-
-	glGenVertexArrays(1, &fontVao);
-	glBindVertexArray(fontVao);
-	glGenBuffers(1, &fontVertexBufferId);
-	glBindBuffer(GL_ARRAY_BUFFER, fontVertexBufferId);
-
-	fontVertexBufferCapacity = 35;
-	fontVertexBufferData = new FontVertex[fontVertexBufferCapacity * 6];
-
-	glBufferData(GL_ARRAY_BUFFER, sizeof(FontVertex) * 6 * fontVertexBufferCapacity, 0, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(FontVertex), 0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(FontVertex), (const void*)offsetof(FontVertex, texCoords));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(FontVertex), (const void*)offsetof(FontVertex, color));
-	glBindVertexArray(0);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
 
-	resource::FreeBinaryFile(TextData);
+void Font::ResetAtlas()
+{
+	for (auto& [Character, g] : LoadedGlyphs)
+	{
+		g.Rasterized = false;
+		g.SlotWidth = 0;
+		g.SlotHeight = 0;
+	}
+	AtlasShelves.clear();
+	AtlasSlotCount = 0;
+	AtlasPixels.clear();
+	AtlasSize = 0;
+	AtlasOverBudget = false;
+	AtlasGeneration++;
+	ResizeAtlas(FONT_ATLAS_INITIAL_SIZE);
+}
 
-	delete[] GlypthBitmap;
+bool Font::AllocateAtlasSlot(Glyph& Target, int Width, int Height)
+{
+	// Use the first shelf the glyph fits in, unless it would waste too much space.
+	for (AtlasShelf& Shelf : AtlasShelves)
+	{
+		if (AtlasSlotCount >= FONT_MAX_ATLAS_SLOTS)
+		{
+			break;
+		}
+		if (Shelf.Height >= Height
+			&& Shelf.Height <= Height + Height / 4 + 4
+			&& Shelf.UsedWidth + Width <= AtlasSize)
+		{
+			Target.SlotIndex = uint16_t(AtlasSlotCount++);
+			Target.SlotX = Shelf.UsedWidth;
+			Target.SlotY = Shelf.Y;
+			Target.SlotWidth = Width;
+			Target.SlotHeight = Shelf.Height;
+			Shelf.UsedWidth += Width;
+			return true;
+		}
+	}
+
+	int ShelfY = AtlasShelves.empty() ? 0 : AtlasShelves.back().Y + AtlasShelves.back().Height;
+	if (ShelfY + Height <= AtlasSize && Width <= AtlasSize && AtlasSlotCount < FONT_MAX_ATLAS_SLOTS)
+	{
+		Target.SlotIndex = uint16_t(AtlasSlotCount++);
+		AtlasShelves.push_back(AtlasShelf{
+			.Y = ShelfY,
+			.Height = Height,
+			.UsedWidth = Width,
+			});
+		Target.SlotX = 0;
+		Target.SlotY = ShelfY;
+		Target.SlotWidth = Width;
+		Target.SlotHeight = Height;
+		return true;
+	}
+
+	int BudgetSize = FONT_ATLAS_INITIAL_SIZE;
+	while (size_t(BudgetSize) * 2 * size_t(BudgetSize) * 2 <= AtlasMemoryBudget)
+	{
+		BudgetSize *= 2;
+	}
+	if (AtlasSize < BudgetSize && AtlasSlotCount < FONT_MAX_ATLAS_SLOTS)
+	{
+		ResizeAtlas(AtlasSize * 2);
+		return AllocateAtlasSlot(Target, Width, Height);
+	}
+
+	// The atlas is full. Replace the least recently used glyph that is large enough.
+	// Glyphs used by the text that is currently being generated are never replaced.
+	Glyph* Oldest = nullptr;
+	for (auto& [Character, g] : LoadedGlyphs)
+	{
+		if (g.SlotWidth >= Width
+			&& g.SlotHeight >= Height
+			&& g.LastUsed != GlyphUseCounter
+			&& (!Oldest || g.LastUsed < Oldest->LastUsed))
+		{
+			Oldest = &g;
+		}
+	}
+
+	if (Oldest)
+	{
+		Target.SlotIndex = Oldest->SlotIndex;
+		Target.SlotX = Oldest->SlotX;
+		Target.SlotY = Oldest->SlotY;
+		Target.SlotWidth = Oldest->SlotWidth;
+		Target.SlotHeight = Oldest->SlotHeight;
+		Oldest->SlotWidth = 0;
+		Oldest->SlotHeight = 0;
+		Oldest->Rasterized = false;
+		AtlasGeneration++;
+		return true;
+	}
+
+	// No glyph can be replaced. Grow past the budget for now, the atlas is cleared before generating the next text.
+	GLint MaxTextureSize = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &MaxTextureSize);
+	if (AtlasSize * 2 <= MaxTextureSize && AtlasSlotCount < FONT_MAX_ATLAS_SLOTS)
+	{
+		AtlasOverBudget = true;
+		ResizeAtlas(AtlasSize * 2);
+		return AllocateAtlasSlot(Target, Width, Height);
+	}
+	return false;
 }
 
-Vec2f Font::GetTextSize(std::vector<TextSegment> Text, float Scale, bool Wrapped, float LengthBeforeWrap, uint32_t MaxLines, Vec2f* EndPos, size_t EndIndex)
+void Font::SetSDFEnabled(bool NewEnabled)
 {
-	LengthBeforeWrap = LengthBeforeWrap * Window::GetActiveWindow()->GetAspectRatio() / Scale;
-	float x = 0.f, y = CharacterSize;
-	float MaxX = 0.0f;
-	size_t CharIndex = 0;
-	size_t TabCharIndex = 0;
-	size_t LastWrapCharIndex = 0;
-	uint32_t CurrentLine = 0;
-	bool FoundEndPos = false;
-	for (auto& seg : Text)
+	// The loading thread reads the mode and the atlas cache.
+	WaitForLoading();
+	if (NewEnabled == UseSDF)
+	{
+		return;
+	}
+	if (AtlasCacheOutdated)
+	{
+		SaveAtlasCache();
+	}
+	UseSDF = NewEnabled;
+	// The glyph sizes depend on the mode, so the metrics have to be loaded again too.
+	LoadedGlyphs.clear();
+	ResetAtlas();
+
+	std::vector<uint8_t> CacheData;
+	if (!CacheDirectory.empty() && FontFile && ReadAtlasCache(CacheData))
+	{
+		ApplyAtlasCache(CacheData);
+	}
+}
+
+bool Font::GetSDFEnabled() const
+{
+	return UseSDF;
+}
+
+void Font::RasterizeGlyph(char32_t Character, Glyph& Target)
+{
+	int w, h, xoff, yoff;
+	uint8_t* Bitmap = nullptr;
+	int Padding = FONT_ATLAS_PADDING;
+	if (UseSDF)
+	{
+		Bitmap = stbtt_GetCodepointSDF(FontInfo,
+			FONT_SDF_SCALE,
+			int(Character),
+			FONT_SDF_PADDING,
+			FONT_SDF_EDGE_VALUE,
+			float(FONT_SDF_EDGE_VALUE) / float(FONT_SDF_PADDING),
+			&w,
+			&h,
+			&xoff,
+			&yoff);
+		// Distance fields aren't blurred when drawing, so linear filtering is the only thing that needs padding.
+		Padding = 2;
+	}
+	else if (auto Preloaded = PreloadedBitmaps.find(Character); Preloaded != PreloadedBitmaps.end())
+	{
+		w = Preloaded->second.Width;
+		h = Preloaded->second.Height;
+		xoff = Preloaded->second.OffsetX;
+		yoff = Preloaded->second.OffsetY;
+		Bitmap = Preloaded->second.Pixels.data();
+	}
+	else
+	{
+		Bitmap = stbtt_GetCodepointBitmap(FontInfo,
+			FONT_GLYPH_SCALE,
+			FONT_GLYPH_SCALE,
+			int(Character),
+			&w,
+			&h,
+			&xoff,
+			&yoff);
+	}
+
+	if (Bitmap && AllocateAtlasSlot(Target, w + Padding, h + Padding))
 	{
-		size_t LastWordIndex = SIZE_MAX;
-		size_t LastWrapIndex = 0;
-		std::u32string SegmentText = internal::GetUnicodeString(seg.Text, true);
-		for (size_t i = 0; i < SegmentText.size(); i++, CharIndex++, TabCharIndex++)
+		// The whole slot is written, so nothing of a replaced glyph is left in the padding.
+		std::vector<uint8_t> SlotPixels = std::vector<uint8_t>(size_t(Target.SlotWidth) * Target.SlotHeight, 0);
+		for (int y = 0; y < h; y++)
 		{
-			if (CurrentLine > MaxLines)
-			{
-				break;
-			}
-			bool IsTab = SegmentText[i] == '\t';
-			if (IsTab)
-			{
-				SegmentText[i] = ' ';
-			}
-			if (EndPos && CharIndex == EndIndex)
-			{
-				EndPos->X = x / 450 / Window::GetActiveWindow()->GetAspectRatio() * Scale;
-				EndPos->Y = y / 450 * Scale;
-				FoundEndPos = true;
-			}
-			if (SegmentText[i] >= 32)
-			{
-				int GlyphIndex = int(SegmentText[i] - 32);
-				if (GlyphIndex < 0)
-				{
-					continue;
-				}
-				if (GlyphIndex > LoadedGlyphs.size())
-				{
-					GlyphIndex = int(LoadedGlyphs.size() - 1);
-				}
-				Glyph g = LoadedGlyphs[GlyphIndex];
-
-				if (IsTab)
-				{
-					int Multiplier = (TabSize - TabCharIndex % TabSize);
-					g.TotalSize.X *= Multiplier;
-					TabCharIndex += Multiplier - 1;
-				}
-
-				if (SegmentText[i] == ' ')
-				{
-					LastWordIndex = i;
-					LastWrapCharIndex = CharIndex;
-				}
-
-				if (((x + g.TotalSize.X) / 450 > LengthBeforeWrap && Wrapped))
-				{
-					CurrentLine++;
-					if (CurrentLine > MaxLines)
-					{
-						break;
-					}
-					x = 0;
-					y += CharacterSize;
-					if (LastWordIndex != SIZE_MAX && LastWordIndex != LastWrapIndex)
-					{
-						i = LastWordIndex;
-						LastWrapIndex = i;
-						CharIndex = LastWrapCharIndex;
-						continue;
-					}
-				}
-
-				x += g.TotalSize.X;
-
-				MaxX = std::max(MaxX, x);
-			}
-			if (SegmentText[i] == (int)'\n')
-			{
-				x = 0;
-				y += CharacterSize;
-				CurrentLine++;
-			}
+			memcpy(&SlotPixels[size_t(y) * Target.SlotWidth], &Bitmap[size_t(y) * w], w);
+		}
+		for (int y = 0; y < Target.SlotHeight; y++)
+		{
+			memcpy(&AtlasPixels[size_t(Target.SlotY + y) * AtlasSize + Target.SlotX], &SlotPixels[size_t(y) * Target.SlotWidth], Target.SlotWidth);
+		}
+
+		glBindTexture(GL_TEXTURE_2D, fontTexture);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage2D(GL_TEXTURE_2D,
+			0,
+			Target.SlotX,
+			Target.SlotY,
+			Target.SlotWidth,
+			Target.SlotHeight,
+			GL_ALPHA,
+			GL_UNSIGNED_BYTE,
+			SlotPixels.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		Target.TexCoordStart = Vec2f((float)Target.SlotX, (float)Target.SlotY);
+		if (UseSDF)
+		{
+			// The quad has to cover the distance values around the glyph, which are included in the bitmap.
+			float PixelSize = FONT_GLYPH_SCALE / FONT_SDF_SCALE / 20.0f;
+			Target.TexCoordOffset = Vec2f((float)w, (float)h);
+			Target.Offset = Vec2f((float)xoff, (float)yoff) * PixelSize;
+			Target.Size = Vec2f((float)w, (float)h) * PixelSize;
+		}
+		else
+		{
+			Target.TexCoordOffset = Vec2f((float)(w + 3), (float)(h + 3));
 		}
+		Target.Rasterized = true;
+
+		size_t MetricsIndex = size_t(Target.SlotIndex) * 8;
+		if (GlyphMetrics.size() < MetricsIndex + 8)
+		{
+			GlyphMetrics.resize(MetricsIndex + 8);
+		}
+		const float SlotMetrics[8] = {
+			Target.TexCoordStart.X, Target.TexCoordStart.Y, Target.TexCoordOffset.X, Target.TexCoordOffset.Y,
+			Target.Offset.X, Target.Offset.Y, Target.Size.X, Target.Size.Y,
+		};
+		memcpy(&GlyphMetrics[MetricsIndex], SlotMetrics, sizeof(SlotMetrics));
+		AtlasCacheOutdated = true;
+		FirstChangedSlot = std::min(FirstChangedSlot, size_t(Target.SlotIndex));
+		EndChangedSlot = std::max(EndChangedSlot, size_t(Target.SlotIndex) + 1);
+	}
+	if (UseSDF)
+	{
+		stbtt_FreeSDF(Bitmap, nullptr);
+	}
+	else if (auto Preloaded = PreloadedBitmaps.find(Character); Preloaded != PreloadedBitmaps.end())
+	{
+		// The bitmap is only needed until it is in the atlas. If it is replaced later, it's rendered again.
+		PreloadedBitmaps.erase(Preloaded);
+	}
+	else
+	{
+		stbtt_FreeBitmap(Bitmap, nullptr);
 	}
-	if (EndPos && !FoundEndPos)
+}
+
+Vec2f Font::GetTextSize(const std::vector<TextSegment>& Text, float Scale, bool Wrapped, float LengthBeforeWrap, uint32_t MaxLines, Vec2f* EndPos, size_t EndIndex)
+{
+	TextLayout Layout;
+	Layout.Update(this, Text, Scale, Wrapped, LengthBeforeWrap, MaxLines);
+	if (EndPos)
 	{
-		EndPos->X = x / 450 / Window::GetActiveWindow()->GetAspectRatio() * Scale;
-		EndPos->Y = y / 450 * Scale;
+		*EndPos = Layout.GetLetterLocation(EndIndex);
 	}
+	return Layout.GetSize();
+}
 
-	return Vec2f(MaxX / 450 / Window::GetActiveWindow()->GetAspectRatio() * Scale, y / 450 * Scale);
+DrawableText* Font::MakeText(const std::vector<TextSegment>& Text, Vec2f Pos, float Scale, Vec3f Color, float opacity, float LengthBeforeWrap, uint32_t MaxLines)
+{
+	DrawableText* NewText = new DrawableText();
+	UpdateText(NewText, Text, Pos, Scale, Color, opacity, LengthBeforeWrap, MaxLines);
+	return NewText;
 }
 
+DrawableText* Font::MakeText(const TextLayout& Layout, Vec2f Pos, Vec3f Color, float opacity)
+{
+	DrawableText* NewText = new DrawableText();
+	UpdateText(NewText, Layout, Pos, Color, opacity);
+	return NewText;
+}
 
-DrawableText* Font::MakeText(std::vector<TextSegment> Text, Vec2f Pos, float Scale, Vec3f Color, float opacity, float LengthBeforeWrap, uint32_t MaxLines)
+void Font::UpdateText(DrawableText* Target, const std::vector<TextSegment>& Text, Vec2f Pos, float Scale, Vec3f Color, float opacity, float LengthBeforeWrap, uint32_t MaxLines)
 {
-	ReplaceTabs(Text, TabSize);
+	TextLayout Layout;
+	Layout.Update(this, Text, Scale, true, LengthBeforeWrap, MaxLines);
+	// The temporary layout doesn't know what changed, and isn't available later to generate the visible lines.
+	Target->TextFont = nullptr;
+	UpdateText(Target, Layout, Pos, Color, opacity);
 
-	GLuint newVAO = 0, newVBO = 0;
-	glGenVertexArrays(1, &newVAO);
-	glBindVertexArray(newVAO);
-	glGenBuffers(1, &newVBO);
-	glBindBuffer(GL_ARRAY_BUFFER, newVBO);
+	if (AtlasOverBudget)
+	{
+		ResetAtlas();
+	}
+	GlyphUseCounter++;
+	GenerateTextBlocks(Target, Layout, 0, Target->Blocks.size());
+}
 
-	glBufferData(GL_ARRAY_BUFFER, sizeof(FontVertex) * 6 * fontVertexBufferCapacity, 0, GL_STATIC_DRAW);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(FontVertex), 0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(FontVertex), (const void*)offsetof(FontVertex, texCoords));
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(FontVertex), (const void*)offsetof(FontVertex, color));
-	glBindVertexArray(0);
+void Font::UpdateText(DrawableText* Target, const TextLayout& Layout, Vec2f Pos, Vec3f Color, float opacity)
+{
+	size_t BlockCount = std::max((Layout.GetLineCount() + FONT_LINES_PER_BLOCK - 1) / FONT_LINES_PER_BLOCK, size_t(1));
+	Target->SetBlockCount(BlockCount);
 
-	LengthBeforeWrap = LengthBeforeWrap * Window::GetActiveWindow()->GetAspectRatio() / Scale;
-	Pos.X = Pos.X * 450 * Window::GetActiveWindow()->GetAspectRatio();
-	Pos.Y = Pos.Y * -450;
-	glBindVertexArray(newVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, newVBO);
-	uint32_t len = (uint32_t)TextSegment::CombineToString(Text).size();
-	if (fontVertexBufferCapacity < len)
-	{
-		fontVertexBufferCapacity = len;
-		glBufferData(GL_ARRAY_BUFFER, sizeof(FontVertex) * 6 * fontVertexBufferCapacity, 0, GL_STATIC_DRAW);
-		delete[] fontVertexBufferData;
-		fontVertexBufferData = new FontVertex[fontVertexBufferCapacity * 6];
-	}
-	float x = 0.f, y = 0.f;
-	FontVertex* vData = fontVertexBufferData;
-	uint32_t numVertices = 0;
-	uint32_t CurrentLine = 0;
-	for (auto& seg : Text)
-	{
-		size_t LastWordIndex = SIZE_MAX;
-		size_t LastWrapIndex = 0;
-		uint32_t LastWordNumVertices = 0;
-		FontVertex* LastWordVDataPtr = nullptr;
-		std::u32string UTFString = internal::GetUnicodeString(seg.Text);
-
-		for (size_t i = 0; i < UTFString.size(); i++)
+	size_t FirstChanged = 0, EndChanged = SIZE_MAX;
+	if (Target->TextFont == this)
+	{
+		Layout.GetChangedLines(Target->LayoutVersion, FirstChanged, EndChanged);
+	}
+	for (size_t i = FirstChanged / FONT_LINES_PER_BLOCK; i < BlockCount && i * FONT_LINES_PER_BLOCK < EndChanged; i++)
+	{
+		Target->Blocks[i].Outdated = true;
+	}
+
+	Target->LayoutVersion = Layout.GetVersion();
+	Target->TextFont = this;
+	Target->Texture = fontTexture;
+	Target->Scale = Layout.GetScale();
+	Target->Color = Color;
+	Target->Opacity = opacity;
+	Target->SetPosition(Pos);
+}
+
+void Font::UpdateVisibleText(DrawableText* Target, const TextLayout& Layout, ScrollObject* CurrentScrollObject)
+{
+	if (AtlasOverBudget)
+	{
+		ResetAtlas();
+	}
+	GlyphUseCounter++;
+
+	size_t FirstLine = 0, EndLine = 0;
+	Target->GetVisibleLines(CurrentScrollObject, FirstLine, EndLine);
+	GenerateTextBlocks(Target, Layout, FirstLine / FONT_LINES_PER_BLOCK,
+		std::min((EndLine + FONT_LINES_PER_BLOCK - 1) / FONT_LINES_PER_BLOCK, Target->Blocks.size()));
+}
+
+void Font::GenerateTextBlocks(DrawableText* Target, const TextLayout& Layout, size_t FirstBlock, size_t EndBlock)
+{
+	const std::vector<TextLayout::LayoutGlyph>& Glyphs = Layout.GetGlyphs();
+	Target->SDF = UseSDF;
+
+	for (size_t BlockIndex = FirstBlock; BlockIndex < EndBlock; BlockIndex++)
+	{
+		DrawableText::TextBlock& Block = Target->Blocks[BlockIndex];
+		if (!Block.Outdated && Block.AtlasGeneration == AtlasGeneration)
 		{
-			if (CurrentLine > MaxLines)
+			continue;
+		}
+
+		size_t FirstGlyph = Layout.GetLineFirstGlyph(BlockIndex * FONT_LINES_PER_BLOCK);
+		size_t EndGlyph = Layout.GetLineFirstGlyph((BlockIndex + 1) * FONT_LINES_PER_BLOCK);
+
+		InstanceData.clear();
+		Block.Runs.clear();
+		for (size_t i = FirstGlyph; i < EndGlyph; i++)
+		{
+			const TextLayout::LayoutGlyph& lg = Glyphs[i];
+			Glyph& g = GetGlyph(lg.Character);
+			if (g.Size != 0 && !g.Rasterized)
+			{
+				RasterizeGlyph(lg.Character, g);
+			}
+			g.LastUsed = GlyphUseCounter;
+			if (g.Size == 0 || !g.Rasterized)
 			{
-				break;
+				continue;
 			}
-			int GlyphIndex = (int)UTFString[i] - 32;
-			if (GlyphIndex >= 0)
+
+			float X = 0, Y = 0;
+			if (!Block.Runs.empty())
 			{
-				if (GlyphIndex > FONT_MAX_UNICODE_CHARS)
-				{
-					GlyphIndex = FONT_MAX_UNICODE_CHARS - 31;
-				}
-				Glyph g = LoadedGlyphs[GlyphIndex];
-
-				if (UTFString[i] == ' ')
-				{
-					LastWordIndex = i;
-					LastWordNumVertices = numVertices;
-					LastWordVDataPtr = vData;
-				}
-
-				if ((x + g.TotalSize.X) / 450 > LengthBeforeWrap)
-				{
-					CurrentLine++;
-					if (CurrentLine > MaxLines)
-					{
-						break;
-					}
-					x = 0;
-					y += CharacterSize;
-					if (LastWordIndex != SIZE_MAX && LastWordIndex != LastWrapIndex)
-					{
-						i = LastWordIndex;
-						LastWrapIndex = i;
-						vData = LastWordVDataPtr;
-						numVertices = LastWordNumVertices;
-						continue;
-					}
-				}
-
-				Vec2 StartPos = Vec2(x, y) + g.Offset;
-				if (g.Size != 0)
-				{
-					vData[0].position = StartPos + Vec2f(0, g.Size.Y); vData[0].texCoords = g.TexCoordStart + Vec2f(0, g.TexCoordOffset.Y);
-					vData[1].position = StartPos + g.Size;             vData[1].texCoords = g.TexCoordStart + g.TexCoordOffset;
-					vData[2].position = StartPos + Vec2f(g.Size.X, 0); vData[2].texCoords = g.TexCoordStart + Vec2f(g.TexCoordOffset.X, 0);
-					vData[3].position = StartPos;                      vData[3].texCoords = g.TexCoordStart;
-					vData[4].position = StartPos + Vec2f(0, g.Size.Y); vData[4].texCoords = g.TexCoordStart + Vec2f(0, g.TexCoordOffset.Y);
-					vData[5].position = StartPos + Vec2f(g.Size.X, 0); vData[5].texCoords = g.TexCoordStart + Vec2f(g.TexCoordOffset.X, 0);
-					vData[0].color = seg.Color;		vData[1].color = seg.Color;
-					vData[2].color = seg.Color;		vData[3].color = seg.Color;
-					vData[4].color = seg.Color;		vData[5].color = seg.Color;
-					vData += 6;
-					numVertices += 6;
-				}
-				x += g.TotalSize.X;
+				X = std::round((lg.Position.X - Block.Runs.back().Origin.X) * FONT_INSTANCE_POSITION_STEPS);
+				Y = std::round((lg.Position.Y - Block.Runs.back().Origin.Y) * FONT_INSTANCE_POSITION_STEPS);
 			}
-			if (UTFString[i] == (int)'\n')
+			if (Block.Runs.empty() || X < INT16_MIN || X > INT16_MAX || Y < INT16_MIN || Y > INT16_MAX)
 			{
-				x = 0;
-				y += CharacterSize;
-				CurrentLine++;
-				if (CurrentLine > MaxLines)
-				{
-					break;
-				}
+				Block.Runs.push_back(DrawableText::TextBlock::Run{
+					.FirstGlyph = unsigned(InstanceData.size()),
+					.Origin = lg.Position,
+					});
+				X = 0;
+				Y = 0;
 			}
+
+			auto ToByte = [](float Value) -> uint32_t {
+				return uint32_t(std::clamp(Value, 0.0f, 1.0f) * 255.0f + 0.5f);
+			};
+			GlyphInstance& New = InstanceData.emplace_back();
+			New.X = int16_t(X);
+			New.Y = int16_t(Y);
+			New.Slot = g.SlotIndex;
+			New.Color = ToByte(lg.Color.X) | ToByte(lg.Color.Y) << 8 | ToByte(lg.Color.Z) << 16 | 0xFF000000u;
+			Block.Runs.back().NumGlyphs++;
+		}
+
+		unsigned int NumGlyphs = unsigned(InstanceData.size());
+		glBindBuffer(GL_ARRAY_BUFFER, Block.VBO);
+		if (NumGlyphs > Block.BufferCapacity)
+		{
+			// Leave some space, so texts that grow while being edited don't need a new buffer every time.
+			Block.BufferCapacity = NumGlyphs + NumGlyphs / 2;
+			glBufferData(GL_ARRAY_BUFFER, sizeof(GlyphInstance) * Block.BufferCapacity, 0, GL_DYNAMIC_DRAW);
 		}
+		glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GlyphInstance) * NumGlyphs, InstanceData.data());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		Block.NumGlyphs = NumGlyphs;
+		Block.Outdated = false;
 	}
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(FontVertex) * numVertices, fontVertexBufferData);
-	return new DrawableText(newVAO, newVBO, numVertices, fontTexture, Pos, Scale, Color, opacity);
+
+	UploadGlyphMetrics();
+
+	// Rendering glyphs might have replaced others in the atlas, so the generation is only stored after all blocks are done.
+	for (size_t BlockIndex = FirstBlock; BlockIndex < EndBlock; BlockIndex++)
+	{
+		Target->Blocks[BlockIndex].AtlasGeneration = AtlasGeneration;
+	}
+}
+
+void Font::UploadGlyphMetrics()
+{
+	if (FirstChangedSlot >= EndChangedSlot)
+	{
+		return;
+	}
+
+	// A 2D texture is used instead of a buffer texture, since GLES 3 doesn't have those.
+	const size_t RowFloats = GlyphMetricsRowSlots * 8;
+	const size_t NeededRows = (GlyphMetrics.size() + RowFloats - 1) / RowFloats;
+	GlyphMetrics.resize(NeededRows * RowFloats);
+
+	glBindTexture(GL_TEXTURE_2D, GlyphMetricsTexture);
+	if (NeededRows > GlyphMetricsRows)
+	{
+		GlyphMetricsRows = std::min(std::max(NeededRows, GlyphMetricsRows * 2),
+			(FONT_MAX_ATLAS_SLOTS + GlyphMetricsRowSlots - 1) / GlyphMetricsRowSlots);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F,
+			GLsizei(GlyphMetricsRowSlots * 2), GLsizei(GlyphMetricsRows), 0, GL_RGBA, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		FirstChangedSlot = 0;
+		EndChangedSlot = GlyphMetrics.size() / 8;
+	}
+	// Only whole rows are uploaded.
+	const size_t FirstRow = FirstChangedSlot / GlyphMetricsRowSlots;
+	const size_t EndRow = std::min((EndChangedSlot + GlyphMetricsRowSlots - 1) / GlyphMetricsRowSlots, NeededRows);
+	glTexSubImage2D(GL_TEXTURE_2D, 0,
+		0, GLint(FirstRow),
+		GLsizei(GlyphMetricsRowSlots * 2), GLsizei(EndRow - FirstRow),
+		GL_RGBA, GL_FLOAT, &GlyphMetrics[FirstRow * RowFloats]);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	FirstChangedSlot = SIZE_MAX;
+	EndChangedSlot = 0;
 }
 
 Font::~Font()
 {
+	if (LoadThread.joinable())
+	{
+		LoadThread.join();
+	}
+	Loaded = true;
+	if (AtlasCacheOutdated)
+	{
+		SaveAtlasCache();
+	}
 	glDeleteTextures(1, &fontTexture);
-	glDeleteBuffers(1, &fontVertexBufferId);
-	glDeleteBuffers(1, &fontVao);
-	if (fontVertexBufferData)
+	glDeleteTextures(1, &GlyphMetricsTexture);
+	delete FontInfo;
+	if (FontFile)
 	{
-		delete[] fontVertexBufferData;
+		resource::FreeBinaryFile(*FontFile);
+		delete FontFile;
 	}
 }
 
@@ -540,24 +1140,97 @@ void OnWindowResized()
 {
 }
 
-DrawableText::DrawableText(unsigned int VAO, unsigned int VBO, unsigned int NumVerts, unsigned int Texture,
-	Vec2f Position, float Scale, Vec3f Color, float opacity)
+DrawableText::DrawableText()
 {
-	this->Position = Position;
-	this->Scale = Scale;
-	this->NumVerts = NumVerts;
-	this->VAO = VAO;
-	this->VBO = VBO;
-	this->Opacity = opacity;
-	this->Texture = Texture;
-	this->Color = Color;
+}
+
+void DrawableText::SetBlockCount(size_t NewCount)
+{
+	for (size_t i = NewCount; i < Blocks.size(); i++)
+	{
+		glDeleteBuffers(1, &Blocks[i].VBO);
+		glDeleteVertexArrays(1, &Blocks[i].VAO);
+	}
+	size_t OldCount = Blocks.size();
+	Blocks.resize(NewCount);
+
+	for (size_t i = OldCount; i < NewCount; i++)
+	{
+		TextBlock& Block = Blocks[i];
+		glGenVertexArrays(1, &Block.VAO);
+		glBindVertexArray(Block.VAO);
+		glGenBuffers(1, &Block.VBO);
+		glBindBuffer(GL_ARRAY_BUFFER, Block.VBO);
+
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribDivisor(0, 1);
+		glVertexAttribDivisor(1, 1);
+		glVertexAttribDivisor(2, 1);
+		BindInstanceAttributes(0);
+	}
+	glBindVertexArray(0);
+}
+
+void DrawableText::BindInstanceAttributes(unsigned int FirstGlyph)
+{
+	size_t Start = sizeof(GlyphInstance) * FirstGlyph;
+	glVertexAttribIPointer(0, 2, GL_SHORT, sizeof(GlyphInstance), (const void*)(Start + offsetof(GlyphInstance, X)));
+	glVertexAttribIPointer(1, 1, GL_UNSIGNED_SHORT, sizeof(GlyphInstance), (const void*)(Start + offsetof(GlyphInstance, Slot)));
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphInstance), (const void*)(Start + offsetof(GlyphInstance, Color)));
+}
+
+void DrawableText::SetPosition(Vec2f NewPosition)
+{
+	Position.X = NewPosition.X * 450 * Window::GetActiveWindow()->GetAspectRatio();
+	Position.Y = NewPosition.Y * -450;
+}
+
+void DrawableText::GetVisibleLines(ScrollObject* CurrentScrollObject, size_t& OutFirst, size_t& OutEnd) const
+{
+	float ClipMin = -1, ClipMax = 1, ScrollOffset = 0;
+	if (CurrentScrollObject)
+	{
+		ScrollOffset = CurrentScrollObject->GetOffset();
+		ClipMin = std::max(ClipMin, CurrentScrollObject->GetPosition().Y);
+		ClipMax = std::min(ClipMax, CurrentScrollObject->GetScale().Y);
+	}
+	if (!TextFont || Scale <= 0 || ClipMin >= ClipMax)
+	{
+		OutFirst = 0;
+		OutEnd = 0;
+		return;
+	}
+
+	// Inverse of the transformation in text.vert, giving the range of visible vertex positions.
+	float Top = (-Position.Y / 450 + ScrollOffset - ClipMax) * 450 / Scale;
+	float Bottom = (-Position.Y / 450 + ScrollOffset - ClipMin) * 450 / Scale;
+	float LineSize = TextFont->CharacterSize;
+
+	// Glyphs can reach a bit outside of their line, so some lines around the visible area are included too.
+	float First = std::floor(Top / LineSize) - 2;
+	float End = std::floor(Bottom / LineSize) + 3;
+	OutFirst = First > 0 ? size_t(First) : 0;
+	OutEnd = End > 0 ? size_t(End) : 0;
 }
 
 void DrawableText::Draw(ScrollObject* CurrentScrollObject) const
 {
+	size_t FirstLine = 0, EndLine = 0;
+	GetVisibleLines(CurrentScrollObject, FirstLine, EndLine);
+	size_t FirstBlock = FirstLine / FONT_LINES_PER_BLOCK;
+	size_t EndBlock = std::min((EndLine + FONT_LINES_PER_BLOCK - 1) / FONT_LINES_PER_BLOCK, Blocks.size());
+	if (FirstBlock >= EndBlock)
+	{
+		return;
+	}
+
 	Shader* TextShader = Font::GetTextShader();
-	glBindVertexArray(VAO);
 	TextShader->Bind();
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, TextFont->GlyphMetricsTexture);
+	TextShader->SetInt("u_glyphs", 1);
 	glActiveTexture(GL_TEXTURE0);
 	glBindTexture(GL_TEXTURE_2D, Texture);
 	TextShader->SetInt("u_texture", 0);
@@ -566,6 +1239,7 @@ void DrawableText::Draw(ScrollObject* CurrentScrollObject) const
 	TextShader->SetVec3("transform", Vec3f(Position.X, Position.Y, Scale));
 	TextShader->SetVec2("u_screenRes", Vec2f(Window::GetActiveWindow()->GetSize().Y * 1.5f));
 	TextShader->SetFloat("u_opacity", Opacity);
+	TextShader->SetInt("u_sdf", SDF);
 	if (CurrentScrollObject != nullptr)
 	{
 		auto Pos = CurrentScrollObject->GetPosition();
@@ -575,11 +1249,58 @@ void DrawableText::Draw(ScrollObject* CurrentScrollObject) const
 	}
 	else
 		TextShader->SetVec3("u_offset", Vec3f(0.0f, -1000.0f, 1000.0f));
-	glDrawArrays(GL_TRIANGLES, 0, NumVerts);
+
+	// Blocks outside of the visible area are skipped entirely.
+	for (size_t i = FirstBlock; i < EndBlock; i++)
+	{
+		const TextBlock& Block = Blocks[i];
+		if (Block.NumGlyphs == 0)
+		{
+			continue;
+		}
+		glBindVertexArray(Block.VAO);
+		if (Block.Runs.size() > 1)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, Block.VBO);
+		}
+		for (const TextBlock::Run& BlockRun : Block.Runs)
+		{
+			if (Block.Runs.size() > 1)
+			{
+				BindInstanceAttributes(BlockRun.FirstGlyph);
+			}
+			TextShader->SetVec2("u_origin", BlockRun.Origin);
+			// Each glyph is a quad made of 6 vertices, expanded in the vertex shader.
+			glDrawArraysInstanced(GL_TRIANGLES, 0, 6, BlockRun.NumGlyphs);
+		}
+		if (Block.Runs.size() > 1)
+		{
+			BindInstanceAttributes(0);
+		}
+	}
+	glBindVertexArray(0);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+bool DrawableText::IsOutdated() const
+{
+	if (!TextFont)
+	{
+		return false;
+	}
+	for (const TextBlock& Block : Blocks)
+	{
+		if (Block.NumGlyphs && (Block.Outdated || Block.AtlasGeneration != TextFont->AtlasGeneration))
+		{
+			return true;
+		}
+	}
+	return false;
 }
 
 DrawableText::~DrawableText()
 {
-	glDeleteBuffers(1, &VBO);
-	glDeleteVertexArrays(1, &VAO);
+	SetBlockCount(0);
 }
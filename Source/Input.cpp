@@ -74,10 +74,13 @@ kui::InputManager::InputManager(Window* Parent)
 		{
 			if (In.TextSelectionStart == In.TextIndex)
 			{
-				do
+				// Remove the continuation bytes of the character too.
+				size_t End = In.TextIndex + 1;
+				while (End < In.Text.size() && (In.Text[End] & char(0xC0)) == char(0x80))
 				{
-					In.Text.erase(In.TextIndex, 1);
-				} while (In.Text.size() && (In.Text[In.TextIndex] & char(0xC0)) == char(0x80));
+					End++;
+				}
+				In.EditText(In.TextIndex, End - In.TextIndex);
 			}
 			else
 			{
@@ -97,18 +100,14 @@ kui::InputManager::InputManager(Window* Parent)
 			{
 				if (In.TextSelectionStart == In.TextIndex)
 				{
-					char c = 0;
-					do
+					// Remove the whole character before the cursor, not just it's last byte.
+					int Start = In.TextIndex - 1;
+					while (Start > 0 && (In.Text[Start] & char(0xC0)) == char(0x80))
 					{
-						In.TextIndex--;
-						In.Text.erase(In.TextIndex, 1);
-						if (In.TextIndex == 0)
-						{
-							break;
-						}
-
-						c = In.Text[In.TextIndex - 1];
-					} while (In.Text.size() && (c & char(0xC0)) != char(0x80) && c <= 0);
+						Start--;
+					}
+					In.EditText(Start, In.TextIndex - Start);
+					In.TextIndex = Start;
 				}
 				else
 				{
@@ -265,7 +264,7 @@ void kui::InputManager::AddTextInput(std::string Str)
 			TextIndex = (int)Text.size();
 		}
 		DeleteTextSelection();
-		Text.insert(TextIndex, Str);
+		EditText(TextIndex, 0, Str);
 		MoveTextIndex((int)Str.size(), false);
 	}
 }
@@ -275,7 +274,10 @@ void kui::InputManager::DeleteTextSelection()
 	if (!CanEditText)
 		return;
 	int Difference = std::abs(TextSelectionStart - TextIndex);
-	Text.erase(std::min(TextIndex, TextSelectionStart), Difference);
+	if (Difference)
+	{
+		EditText(std::min(TextIndex, TextSelectionStart), Difference);
+	}
 	SetTextIndex(std::min(TextIndex, TextSelectionStart), true);
 }
 
@@ -355,6 +357,35 @@ std::string kui::InputManager::GetSelectedTextString() const
 	return Text.substr(Start, End - Start);
 }
 
+bool kui::InputManager::GetTextEditsSince(uint64_t Revision, std::vector<TextEdit>& OutEdits) const
+{
+	uint64_t Count = TextRevision - Revision;
+	if (Revision > TextRevision || Count > RecentTextEdits.size())
+	{
+		return false;
+	}
+	OutEdits.assign(RecentTextEdits.end() - Count, RecentTextEdits.end());
+	return true;
+}
+
+void kui::InputManager::EditText(size_t Start, size_t RemovedLength, const std::string& Inserted)
+{
+	// Only a few changes are kept. A text field that missed more than that reads the whole text again.
+	constexpr size_t MAX_RECENT_EDITS = 64;
+
+	Text.replace(Start, RemovedLength, Inserted);
+	if (RecentTextEdits.size() >= MAX_RECENT_EDITS)
+	{
+		RecentTextEdits.erase(RecentTextEdits.begin());
+	}
+	RecentTextEdits.push_back(TextEdit{
+		.Start = Start,
+		.RemovedLength = RemovedLength,
+		.Inserted = Inserted,
+		});
+	TextRevision++;
+}
+
 void kui::InputManager::SetTextIndex(int NewIndex, bool ClearSelection)
 {
 	TextIndex = NewIndex;
@@ -0,0 +1,213 @@
+#include "DamageMap.h"
+#include <algorithm>
+#include <cmath>
+using namespace kui;
+using namespace kui::internal;
+
+void DamageMap::SetSize(Vec2ui NewSize)
+{
+	if (NewSize == Size)
+	{
+		return;
+	}
+	Size = NewSize;
+	TilesX = uint32_t((Size.X + TileSize - 1) / TileSize);
+	TilesY = uint32_t((Size.Y + TileSize - 1) / TileSize);
+	WordsPerRow = (TilesX + 63) / 64;
+	Tiles.assign(size_t(WordsPerRow) * TilesY, 0);
+	DrawnFrames.clear();
+	AddAll();
+}
+
+Vec2ui DamageMap::GetSize() const
+{
+	return Size;
+}
+
+bool DamageMap::GetTileRange(Vec2f Min, Vec2f Max, uint32_t Margin, uint32_t& OutX0, uint32_t& OutY0, uint32_t& OutX1, uint32_t& OutY1) const
+{
+	if (TilesX == 0 || TilesY == 0)
+	{
+		return false;
+	}
+	Vec2f PixelMin = (Min / 2 + 0.5f) * Vec2f(Size) - float(Margin);
+	Vec2f PixelMax = (Max / 2 + 0.5f) * Vec2f(Size) + float(Margin);
+	if (PixelMax.X <= 0 || PixelMax.Y <= 0 || PixelMin.X >= float(Size.X) || PixelMin.Y >= float(Size.Y)
+		|| PixelMax.X < PixelMin.X || PixelMax.Y < PixelMin.Y)
+	{
+		return false;
+	}
+	OutX0 = uint32_t(std::max(PixelMin.X, 0.0f)) / TileSize;
+	OutY0 = uint32_t(std::max(PixelMin.Y, 0.0f)) / TileSize;
+	OutX1 = std::min(uint32_t(std::ceil(PixelMax.X)) / TileSize, TilesX - 1);
+	OutY1 = std::min(uint32_t(std::ceil(PixelMax.Y)) / TileSize, TilesY - 1);
+	return true;
+}
+
+void DamageMap::Add(Vec2f Min, Vec2f Max, uint32_t Margin)
+{
+	uint32_t X0, Y0, X1, Y1;
+	if (!GetTileRange(Min, Max, Margin, X0, Y0, X1, Y1))
+	{
+		return;
+	}
+	for (uint32_t y = Y0; y <= Y1; y++)
+	{
+		uint64_t* Row = &Tiles[size_t(y) * WordsPerRow];
+		for (uint32_t x = X0; x <= X1; x++)
+		{
+			Row[x / 64] |= uint64_t(1) << (x % 64);
+		}
+	}
+	Empty = false;
+}
+
+void DamageMap::AddAll()
+{
+	Add(-1, 1, 0);
+}
+
+bool DamageMap::IsDamaged(Vec2f Min, Vec2f Max) const
+{
+	uint32_t X0, Y0, X1, Y1;
+	if (Empty || !GetTileRange(Min, Max, 0, X0, Y0, X1, Y1))
+	{
+		return false;
+	}
+	for (uint32_t y = Y0; y <= Y1; y++)
+	{
+		const uint64_t* Row = &Tiles[size_t(y) * WordsPerRow];
+		for (uint32_t x = X0; x <= X1; x++)
+		{
+			if (Row[x / 64] & (uint64_t(1) << (x % 64)))
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool DamageMap::GetTileRect(Vec2f Min, Vec2f Max, uint32_t Margin, Rect& OutRect) const
+{
+	uint32_t X0, Y0, X1, Y1;
+	if (!GetTileRange(Min, Max, Margin, X0, Y0, X1, Y1))
+	{
+		return false;
+	}
+	OutRect.X = X0 * TileSize;
+	OutRect.Y = Y0 * TileSize;
+	OutRect.Width = std::min((X1 + 1) * TileSize, uint32_t(Size.X)) - OutRect.X;
+	OutRect.Height = std::min((Y1 + 1) * TileSize, uint32_t(Size.Y)) - OutRect.Y;
+	return true;
+}
+
+void DamageMap::Remove(const Rect& Area)
+{
+	if (Empty || Area.Width == 0 || Area.Height == 0)
+	{
+		return;
+	}
+	const uint32_t X0 = Area.X / TileSize, Y0 = Area.Y / TileSize;
+	const uint32_t X1 = std::min((Area.X + Area.Width + TileSize - 1) / TileSize, TilesX);
+	const uint32_t Y1 = std::min((Area.Y + Area.Height + TileSize - 1) / TileSize, TilesY);
+	for (uint32_t y = Y0; y < Y1; y++)
+	{
+		uint64_t* Row = &Tiles[size_t(y) * WordsPerRow];
+		for (uint32_t x = X0; x < X1; x++)
+		{
+			Row[x / 64] &= ~(uint64_t(1) << (x % 64));
+		}
+	}
+	Empty = std::all_of(Tiles.begin(), Tiles.end(), [](uint64_t Word) { return Word == 0; });
+}
+
+bool DamageMap::IsEmpty() const
+{
+	return Empty;
+}
+
+void DamageMap::Clear()
+{
+	std::fill(Tiles.begin(), Tiles.end(), 0);
+	Empty = true;
+}
+
+void DamageMap::GetRects(std::vector<Rect>& OutRects) const
+{
+	OutRects.clear();
+	if (Empty)
+	{
+		return;
+	}
+
+	// Rectangles that ended in the previous row, and can still be extended by a run in the current row.
+	std::vector<size_t> OpenRects, NextOpenRects;
+	for (uint32_t y = 0; y < TilesY; y++)
+	{
+		const uint64_t* Row = &Tiles[size_t(y) * WordsPerRow];
+		NextOpenRects.clear();
+		uint32_t x = 0;
+		while (x < TilesX)
+		{
+			if (!(Row[x / 64] & (uint64_t(1) << (x % 64))))
+			{
+				x++;
+				continue;
+			}
+			uint32_t RunStart = x;
+			while (x < TilesX && (Row[x / 64] & (uint64_t(1) << (x % 64))))
+			{
+				x++;
+			}
+
+			uint32_t PixelX = RunStart * TileSize;
+			uint32_t PixelWidth = std::min(x * TileSize, uint32_t(Size.X)) - PixelX;
+			uint32_t PixelY = y * TileSize;
+			uint32_t PixelHeight = std::min((y + 1) * TileSize, uint32_t(Size.Y)) - PixelY;
+
+			auto Open = std::find_if(OpenRects.begin(), OpenRects.end(), [&](size_t Index) {
+				return OutRects[Index].X == PixelX && OutRects[Index].Width == PixelWidth;
+				});
+			if (Open != OpenRects.end())
+			{
+				OutRects[*Open].Height += PixelHeight;
+				NextOpenRects.push_back(*Open);
+			}
+			else
+			{
+				NextOpenRects.push_back(OutRects.size());
+				OutRects.push_back(Rect{
+					.X = PixelX,
+					.Y = PixelY,
+					.Width = PixelWidth,
+					.Height = PixelHeight,
+					});
+			}
+		}
+		std::swap(OpenRects, NextOpenRects);
+	}
+}
+
+void DamageMap::AddDrawnFrame(const std::vector<Rect>& Rects)
+{
+	if (DrawnFrames.size() >= MaxFrameHistory)
+	{
+		DrawnFrames.erase(DrawnFrames.begin());
+	}
+	DrawnFrames.push_back(Rects);
+}
+
+bool DamageMap::GetDrawnRects(int Age, std::vector<Rect>& OutRects) const
+{
+	OutRects.clear();
+	if (Age <= 0 || size_t(Age) > DrawnFrames.size())
+	{
+		return false;
+	}
+	for (size_t i = DrawnFrames.size() - size_t(Age); i < DrawnFrames.size(); i++)
+	{
+		OutRects.insert(OutRects.end(), DrawnFrames[i].begin(), DrawnFrames[i].end());
+	}
+	return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <kui/Vec2.h>
+#include <vector>
+#include <cstdint>
+
+namespace kui::internal
+{
+	/**
+	 * @brief
+	 * Tracks which parts of the window have to be redrawn, as a grid of fixed size tiles.
+	 *
+	 * Damaged areas are recorded exactly at tile granularity, so distant changes don't grow into one large area.
+	 * Before drawing, the damaged tiles are combined into as few rectangles as possible.
+	 */
+	class DamageMap
+	{
+	public:
+		/// The size of a tile in pixels.
+		static constexpr uint32_t TileSize = 64;
+
+		/**
+		 * @brief
+		 * A rectangle in pixels, with the origin in the bottom left corner of the window.
+		 */
+		struct Rect
+		{
+			uint32_t X = 0, Y = 0;
+			uint32_t Width = 0, Height = 0;
+		};
+
+		/**
+		 * @brief
+		 * Changes the size of the window the map covers. All tiles are damaged if the size has changed.
+		 */
+		void SetSize(Vec2ui NewSize);
+		Vec2ui GetSize() const;
+
+		/**
+		 * @brief
+		 * Damages all tiles overlapping the given rectangle, in screen coordinates (-1 to 1).
+		 *
+		 * @param Margin
+		 * Number of pixels the rectangle is extended by on each side.
+		 */
+		void Add(Vec2f Min, Vec2f Max, uint32_t Margin);
+		void AddAll();
+
+		/**
+		 * @brief
+		 * True if any tile that overlaps the given rectangle, in screen coordinates, is damaged.
+		 */
+		bool IsDamaged(Vec2f Min, Vec2f Max) const;
+
+		/**
+		 * @brief
+		 * Gets the rectangle covered by all tiles overlapping the given rectangle, in screen coordinates.
+		 *
+		 * @return
+		 * False if the rectangle is outside of the map.
+		 */
+		bool GetTileRect(Vec2f Min, Vec2f Max, uint32_t Margin, Rect& OutRect) const;
+
+		/**
+		 * @brief
+		 * Removes the damage of all tiles inside of the given rectangle. The rectangle has to be aligned to tiles, see GetTileRect().
+		 */
+		void Remove(const Rect& Area);
+		bool IsEmpty() const;
+		void Clear();
+
+		/**
+		 * @brief
+		 * Combines the damaged tiles into rectangles. Horizontal runs of tiles are merged with the runs
+		 * of the rows above them if they have the same start and end.
+		 */
+		void GetRects(std::vector<Rect>& OutRects) const;
+
+		/**
+		 * @brief
+		 * Stores the rectangles that have been drawn in a frame, so older back buffers of the window can be updated too.
+		 */
+		void AddDrawnFrame(const std::vector<Rect>& Rects);
+
+		/**
+		 * @brief
+		 * Gets the rectangles that have been drawn in the last Age frames, including the current one.
+		 *
+		 * @return
+		 * False if these frames aren't known, and everything has to be presented again.
+		 */
+		bool GetDrawnRects(int Age, std::vector<Rect>& OutRects) const;
+
+		/// The number of drawn frames that are remembered.
+		static constexpr size_t MaxFrameHistory = 4;
+
+	private:
+		bool GetTileRange(Vec2f Min, Vec2f Max, uint32_t Margin, uint32_t& OutX0, uint32_t& OutY0, uint32_t& OutX1, uint32_t& OutY1) const;
+
+		Vec2ui Size;
+		uint32_t TilesX = 0, TilesY = 0;
+		/// Number of 64 bit words of each row in Tiles.
+		uint32_t WordsPerRow = 0;
+		/// One bit for every tile, row by row.
+		std::vector<uint64_t> Tiles;
+		bool Empty = true;
+		/// The rectangles of the most recently drawn frames, oldest first.
+		std::vector<std::vector<Rect>> DrawnFrames;
+	};
+}
@@ -0,0 +1,227 @@
+#include "HoverIndex.h"
+#include <kui/UI/UIBox.h>
+#include <kui/UI/UIScrollBox.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace kui;
+using namespace kui::internal;
+
+void HoverIndex::Clear()
+{
+	Grids.clear();
+	Entries.clear();
+}
+
+void HoverIndex::UpdateBox(UIBox* Box, Vec2f Position, Vec2f Size, ScrollObject* Scroll)
+{
+	if (!std::isfinite(Position.X) || !std::isfinite(Position.Y) || !std::isfinite(Size.X) || !std::isfinite(Size.Y))
+	{
+		RemoveBox(Box);
+		return;
+	}
+
+	auto Found = Entries.find(Box);
+	if (Found != Entries.end())
+	{
+		Entry& Existing = Found->second;
+		if (Existing.Min == Position && Existing.Max == Position + Size && Existing.Scroll == Scroll)
+		{
+			return;
+		}
+		Erase(Existing);
+	}
+	else
+	{
+		Found = Entries.insert({ Box, Entry() }).first;
+		Found->second.Box = Box;
+	}
+
+	Entry& Target = Found->second;
+	Target.Min = Position;
+	Target.Max = Position + Size;
+	Target.Scroll = Scroll;
+	Insert(Target);
+}
+
+void HoverIndex::RemoveBox(UIBox* Box)
+{
+	auto Found = Entries.find(Box);
+	if (Found == Entries.end())
+	{
+		return;
+	}
+	Erase(Found->second);
+	Entries.erase(Found);
+}
+
+uint64_t HoverIndex::GetCellKey(int32_t X, int32_t Y)
+{
+	return (uint64_t(uint32_t(X)) << 32) | uint64_t(uint32_t(Y));
+}
+
+int32_t HoverIndex::GetCell(float Position)
+{
+	return int32_t(std::floor(Position / CellSize));
+}
+
+void HoverIndex::Insert(Entry& NewEntry)
+{
+	Grid& g = Grids[NewEntry.Scroll];
+	g.NumEntries++;
+
+	NewEntry.CellX0 = GetCell(NewEntry.Min.X);
+	NewEntry.CellY0 = GetCell(NewEntry.Min.Y);
+	NewEntry.CellX1 = GetCell(NewEntry.Max.X);
+	NewEntry.CellY1 = GetCell(NewEntry.Max.Y);
+	int64_t NumCells = (int64_t(NewEntry.CellX1) - NewEntry.CellX0 + 1) * (int64_t(NewEntry.CellY1) - NewEntry.CellY0 + 1);
+	NewEntry.Large = NumCells > MaxBoxCells;
+
+	if (NewEntry.Large)
+	{
+		g.LargeEntries.push_back(&NewEntry);
+		return;
+	}
+	for (int32_t y = NewEntry.CellY0; y <= NewEntry.CellY1; y++)
+	{
+		for (int32_t x = NewEntry.CellX0; x <= NewEntry.CellX1; x++)
+		{
+			g.Cells[GetCellKey(x, y)].push_back(&NewEntry);
+		}
+	}
+}
+
+void HoverIndex::Erase(const Entry& OldEntry)
+{
+	auto FoundGrid = Grids.find(OldEntry.Scroll);
+	if (FoundGrid == Grids.end())
+	{
+		return;
+	}
+	Grid& g = FoundGrid->second;
+
+	// The order of entries in a cell doesn't matter, so they can be swapped with the last one.
+	auto RemoveFrom = [&OldEntry](std::vector<const Entry*>& List) {
+		auto Found = std::find(List.begin(), List.end(), &OldEntry);
+		if (Found != List.end())
+		{
+			*Found = List.back();
+			List.pop_back();
+		}
+	};
+
+	if (OldEntry.Large)
+	{
+		RemoveFrom(g.LargeEntries);
+	}
+	else
+	{
+		for (int32_t y = OldEntry.CellY0; y <= OldEntry.CellY1; y++)
+		{
+			for (int32_t x = OldEntry.CellX0; x <= OldEntry.CellX1; x++)
+			{
+				auto Cell = g.Cells.find(GetCellKey(x, y));
+				if (Cell == g.Cells.end())
+				{
+					continue;
+				}
+				RemoveFrom(Cell->second);
+				if (Cell->second.empty())
+				{
+					g.Cells.erase(Cell);
+				}
+			}
+		}
+	}
+
+	if (--g.NumEntries == 0)
+	{
+		Grids.erase(FoundGrid);
+	}
+}
+
+UIBox* HoverIndex::FindHoveredBox(Vec2f Position) const
+{
+	UIBox* HoveredBox = nullptr;
+
+	auto Check = [&](const Entry* e, Vec2f GridPosition) {
+		if (GridPosition.X < e->Min.X || GridPosition.Y < e->Min.Y || GridPosition.X > e->Max.X || GridPosition.Y > e->Max.Y)
+		{
+			return;
+		}
+		if (HoveredBox && !IsDrawnAfter(e->Box, HoveredBox))
+		{
+			return;
+		}
+		// IsBeingHovered() also checks if the box has been scrolled out of its scroll box.
+		if (e->Box->HasMouseCollision && e->Box->IsVisibleInHierarchy() && e->Box->IsBeingHovered())
+		{
+			HoveredBox = e->Box;
+		}
+	};
+
+	for (const auto& [Scroll, g] : Grids)
+	{
+		Vec2f GridPosition = Position;
+		if (Scroll)
+		{
+			GridPosition.Y -= Scroll->GetOffset();
+		}
+
+		auto Cell = g.Cells.find(GetCellKey(GetCell(GridPosition.X), GetCell(GridPosition.Y)));
+		if (Cell != g.Cells.end())
+		{
+			for (const Entry* e : Cell->second)
+			{
+				Check(e, GridPosition);
+			}
+		}
+		for (const Entry* e : g.LargeEntries)
+		{
+			Check(e, GridPosition);
+		}
+	}
+	return HoveredBox;
+}
+
+bool HoverIndex::IsDrawnAfter(const UIBox* A, const UIBox* B)
+{
+	size_t DepthA = GetDepth(A);
+	size_t DepthB = GetDepth(B);
+
+	// Move the deeper box up until both are at the same depth.
+	const UIBox* ParentA = A;
+	const UIBox* ParentB = B;
+	for (; DepthA > DepthB; DepthA--)
+	{
+		ParentA = ParentA->Parent;
+	}
+	for (; DepthB > DepthA; DepthB--)
+	{
+		ParentB = ParentB->Parent;
+	}
+	if (ParentA == ParentB)
+	{
+		// One box is a child of the other, or both are the same box. Children are drawn after their parents.
+		return A != ParentA;
+	}
+
+	// Find the children of the common parent containing A and B. Roots have no common parent,
+	// but their sibling order is the order of the root list.
+	while (ParentA->Parent != ParentB->Parent)
+	{
+		ParentA = ParentA->Parent;
+		ParentB = ParentB->Parent;
+	}
+	return ParentA->SiblingOrder > ParentB->SiblingOrder;
+}
+
+size_t HoverIndex::GetDepth(const UIBox* Box)
+{
+	size_t Depth = 0;
+	for (const UIBox* i = Box->Parent; i; i = i->Parent)
+	{
+		Depth++;
+	}
+	return Depth;
+}
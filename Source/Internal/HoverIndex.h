@@ -0,0 +1,82 @@
+#pragma once
+#include <kui/Vec2.h>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace kui
+{
+	class UIBox;
+	class ScrollObject;
+}
+
+namespace kui::internal
+{
+	/**
+	 * @brief
+	 * Spatial index over the laid out rectangles of UI boxes, used to find the hovered box.
+	 *
+	 * Boxes are grouped by their scroll object and stored in one sparse grid of fixed size cells per group.
+	 * The grids use unscrolled coordinates, so scrolling only changes the query position.
+	 * A box is only moved in the index when its position, size or scroll object changes.
+	 */
+	class HoverIndex
+	{
+	public:
+		void Clear();
+
+		/**
+		 * @brief
+		 * Adds a box to the index, or moves it if it has already been added.
+		 *
+		 * Boxes without a valid position are removed from the index.
+		 */
+		void UpdateBox(UIBox* Box, Vec2f Position, Vec2f Size, ScrollObject* Scroll);
+		void RemoveBox(UIBox* Box);
+
+		/**
+		 * @brief
+		 * Finds the top-most visible box with mouse collision that is below the given position.
+		 */
+		UIBox* FindHoveredBox(Vec2f Position) const;
+
+		/// The size of a grid cell, in screen units.
+		static constexpr float CellSize = 0.125f;
+		/// Boxes covering more cells than this are stored in a separate list instead of the cells.
+		static constexpr int64_t MaxBoxCells = 64;
+
+	private:
+		struct Entry
+		{
+			UIBox* Box = nullptr;
+			Vec2f Min;
+			Vec2f Max;
+			ScrollObject* Scroll = nullptr;
+			int32_t CellX0 = 0, CellY0 = 0, CellX1 = 0, CellY1 = 0;
+			bool Large = false;
+		};
+
+		struct Grid
+		{
+			std::unordered_map<uint64_t, std::vector<const Entry*>> Cells;
+			/// Boxes that cover too many cells to be stored in them.
+			std::vector<const Entry*> LargeEntries;
+			size_t NumEntries = 0;
+		};
+
+		void Insert(Entry& NewEntry);
+		void Erase(const Entry& OldEntry);
+		static uint64_t GetCellKey(int32_t X, int32_t Y);
+		static int32_t GetCell(float Position);
+
+		/**
+		 * @brief
+		 * True if A is drawn after B. Children are drawn after their parents and after their previous siblings.
+		 */
+		static bool IsDrawnAfter(const UIBox* A, const UIBox* B);
+		static size_t GetDepth(const UIBox* Box);
+
+		std::unordered_map<ScrollObject*, Grid> Grids;
+		std::unordered_map<UIBox*, Entry> Entries;
+	};
+}
@@ -1,10 +1,10 @@
 #include "Internal.h"
 #include "OpenGL.h"
+#include "DamageMap.h"
 #include <kui/Rendering/Shader.h>
 #include <kui/App.h>
 #include "../SystemWM/SystemWM.h"
 #include <mutex>
-#include <cassert>
 
 bool IsGLEWStarted = false;
 std::mutex kui::internal::WindowCreationMutex;
@@ -43,6 +43,10 @@ void kui::internal::DrawWindow(Window* Target)
 
 	systemWM::SysWindow* SysWindow = static_cast<systemWM::SysWindow*>(Target->GetSysWindow());
 
+	// If the back buffer still contains an older frame, only the parts drawn since then have to be copied to it.
+	std::vector<DamageMap::Rect> PresentedRects;
+	bool Partial = Target->UI.GetDamageMap()->GetDrawnRects(systemWM::GetBufferAge(SysWindow), PresentedRects);
+
 	Shader* WindowShader = Target->Shaders.GetShader("WindowShader");
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	WindowShader->Bind();
@@ -52,78 +56,39 @@ void kui::internal::DrawWindow(Window* Target)
 	WindowShader->SetInt("u_ui", 0);
 	WindowShader->SetInt("u_hasWindowBorder", int((Target->GetWindowFlags() & Window::WindowFlag::Borderless) == Window::WindowFlag::Borderless && !Target->GetWindowFullScreen()));
 	WindowShader->SetVec2("u_screenRes", Target->GetSize());
+	WindowShader->SetVec2("u_uvScale", Target->UI.GetFramebufferUVScale());
 	WindowShader->SetVec3("u_borderColor", Target->BorderColor);
 
-	glDrawArrays(GL_TRIANGLES, 0, 3);
-	WindowShader->Unbind();
-
-	systemWM::SwapWindow(SysWindow);
-}
-
-std::u32string kui::internal::GetUnicodeString(std::string utf8, bool SameLength)
-{
-	std::u32string unicode;
-	unicode.reserve(utf8.size());
-	size_t i = 0;
-	while (i < utf8.size())
+	if (Partial)
 	{
-		unsigned long uni;
-		size_t todo;
-		unsigned char ch = utf8[i++];
-		if (ch <= 0x7F)
-		{
-			uni = ch;
-			todo = 0;
-		}
-		else if (ch <= 0xBF)
-		{
-			return std::u32string(utf8.begin(), utf8.end());
-		}
-		else if (ch <= 0xDF)
-		{
-			uni = ch & 0x1F;
-			todo = 1;
-		}
-		else if (ch <= 0xEF)
+		glEnable(GL_SCISSOR_TEST);
+		for (const DamageMap::Rect& Rect : PresentedRects)
 		{
-			uni = ch & 0x0F;
-			todo = 2;
+			glScissor(GLint(Rect.X), GLint(Rect.Y), GLsizei(Rect.Width), GLsizei(Rect.Height));
+			glDrawArrays(GL_TRIANGLES, 0, 3);
 		}
-		else if (ch <= 0xF7)
-		{
-			uni = ch & 0x07;
-			todo = 3;
-		}
-		else
-		{
-			return std::u32string(utf8.begin(), utf8.end());
-		}
-		for (size_t j = 0; j < todo; ++j)
-		{
-			if (i == utf8.size())
-				return std::u32string(utf8.begin(), utf8.end());
-			unsigned char ch = utf8[i++];
-			if (ch < 0x80 || ch > 0xBF)
-				return std::u32string(utf8.begin(), utf8.end());
-			uni <<= 6;
-			uni += ch & 0x3F;
-		}
-		if (uni >= 0xD800 && uni <= 0xDFFF)
-			return std::u32string(utf8.begin(), utf8.end());
-		if (uni > 0x10FFFF)
-			return std::u32string(utf8.begin(), utf8.end());
-		unicode.push_back(uni);
-		if (SameLength)
+		glDisable(GL_SCISSOR_TEST);
+	}
+	else
+	{
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+	}
+	WindowShader->Unbind();
+
+	if (Partial)
+	{
+		// The compositor only needs to know what changed since the previous frame.
+		std::vector<DamageMap::Rect> ChangedRects;
+		Target->UI.GetDamageMap()->GetDrawnRects(1, ChangedRects);
+		std::vector<int32_t> SwapRects;
+		for (const DamageMap::Rect& Rect : ChangedRects)
 		{
-			for (size_t j = 0; j < todo; j++)
-			{
-				unicode.push_back(1);
-			}
+			SwapRects.insert(SwapRects.end(), { int32_t(Rect.X), int32_t(Rect.Y), int32_t(Rect.Width), int32_t(Rect.Height) });
 		}
+		systemWM::SwapWindowWithDamage(SysWindow, SwapRects);
 	}
-	if (SameLength)
+	else
 	{
-		assert(utf8.size() == unicode.size());
+		systemWM::SwapWindow(SysWindow);
 	}
-	return unicode;
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include <kui/Window.h>
 #include <mutex>
+#include <string_view>
+#include <vector>
 
 namespace kui::internal
 {
@@ -12,7 +14,24 @@ namespace kui::internal
 	
 	void* GetGLFWMonitorOfWindow(Window* Target);
 
-	std::u32string GetUnicodeString(std::string utf8, bool SameLength = false);
+	std::u32string GetUnicodeString(const std::string& utf8);
+
+	/**
+	* @brief
+	* Decodes a UTF-8 string. Invalid bytes are decoded as U+FFFD, one character per byte.
+	*
+	* @param OutByteOffsets
+	* If not null, receives the index of the first byte of every character, followed by the length of the string.
+	*/
+	void DecodeUTF8(std::string_view utf8, std::u32string& OutCharacters, std::vector<uint32_t>* OutByteOffsets);
+
+	/**
+	* @brief
+	* Decodes a UTF-8 string one character at a time, without the SIMD fast path for ASCII.
+	*
+	* Gives the same result as DecodeUTF8(). Only used to compare the performance of both, see Examples/UTF8Benchmark.
+	*/
+	void DecodeUTF8Scalar(std::string_view utf8, std::u32string& OutCharacters, std::vector<uint32_t>* OutByteOffsets);
 
 	extern std::mutex WindowCreationMutex;
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "LayerCache.h"
+#include "OpenGL.h"
+#include <kui/Rendering/Shader.h>
+using namespace kui;
+using namespace kui::internal;
+
+thread_local unsigned int LayerCache::ActiveLayers = 0;
+
+LayerCache::~LayerCache()
+{
+	if (Framebuffer)
+	{
+		glDeleteFramebuffers(1, &Framebuffer);
+		glDeleteTextures(1, &Texture);
+	}
+}
+
+void LayerCache::Begin(Vec2i NewPosition, Vec2ui Size, Vec2ui NewWindowSize, bool HighPrecision)
+{
+	Position = NewPosition;
+	WindowSize = NewWindowSize;
+
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, PreviousViewport);
+	glGetIntegerv(GL_SCISSOR_BOX, PreviousScissor);
+
+	if (Size != TextureSize || HighPrecision != TextureHighPrecision)
+	{
+		if (Framebuffer)
+		{
+			glDeleteFramebuffers(1, &Framebuffer);
+			glDeleteTextures(1, &Texture);
+		}
+		TextureSize = Size;
+		TextureHighPrecision = HighPrecision;
+		glGenFramebuffers(1, &Framebuffer);
+		glGenTextures(1, &Texture);
+		glBindTexture(GL_TEXTURE_2D, Texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, HighPrecision ? GL_RGBA16F : GL_RGBA8, GLsizei(Size.X), GLsizei(Size.Y), 0,
+			GL_RGBA, HighPrecision ? GL_FLOAT : GL_UNSIGNED_BYTE, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, Texture, 0);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, Framebuffer);
+	// The window is moved so the layer's area ends up at the origin of the texture.
+	glViewport(GLint(-Position.X), GLint(-Position.Y), GLsizei(WindowSize.X), GLsizei(WindowSize.Y));
+	glScissor(0, 0, GLsizei(Size.X), GLsizei(Size.Y));
+	glClearColor(0, 0, 0, 0);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	ActiveLayers++;
+	ApplyBlendMode();
+}
+
+void LayerCache::End()
+{
+	ActiveLayers--;
+	ApplyBlendMode();
+	glBindFramebuffer(GL_FRAMEBUFFER, GLuint(PreviousFramebuffer));
+	glViewport(PreviousViewport[0], PreviousViewport[1], PreviousViewport[2], PreviousViewport[3]);
+	glScissor(PreviousScissor[0], PreviousScissor[1], PreviousScissor[2], PreviousScissor[3]);
+	Dirty = false;
+}
+
+void LayerCache::Draw(Shader* LayerShader)
+{
+	if (!Framebuffer)
+	{
+		return;
+	}
+
+	const Vec2f Min = Vec2f(Position) / Vec2f(WindowSize) * 2 - 1;
+	const Vec2f Max = Vec2f(Position + Vec2i(TextureSize)) / Vec2f(WindowSize) * 2 - 1;
+
+	LayerShader->Bind();
+	LayerShader->SetVec4("u_transform", Min.X, Min.Y, Max.X, Max.Y);
+	LayerShader->SetInt("u_layer", 0);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, Texture);
+
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	ApplyBlendMode();
+	LayerShader->Unbind();
+}
+
+void LayerCache::ApplyBlendMode()
+{
+	if (ActiveLayers)
+	{
+		// Layers store premultiplied colors, and the alpha of everything drawn into them.
+		glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	}
+	else
+	{
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	}
+}
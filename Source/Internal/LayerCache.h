@@ -0,0 +1,69 @@
+#pragma once
+#include <kui/Vec2.h>
+
+namespace kui
+{
+	class Shader;
+}
+
+namespace kui::internal
+{
+	/**
+	 * @brief
+	 * A texture containing the drawn image of a UI box and it's children. See UIBox::SetLayerCached().
+	 *
+	 * The layer is drawn with the same screen coordinates as the window, only the viewport is moved,
+	 * so elements don't need to know if they are drawn into a layer.
+	 * Colors in the layer texture have premultiplied alpha, so it can be drawn on top of anything.
+	 */
+	class LayerCache
+	{
+	public:
+		~LayerCache();
+
+		/// True if the contents of the layer have changed since it has last been drawn.
+		bool Dirty = true;
+
+		/**
+		 * @brief
+		 * Starts drawing into the layer. Until End() is called, everything drawn ends up in the layer texture.
+		 *
+		 * @param Position
+		 * The pixel position of the bottom left corner of the layer in the window.
+		 *
+		 * @param Size
+		 * The size of the layer in pixels.
+		 *
+		 * @param HighPrecision
+		 * True if the layer texture should use 16 bit floats instead of 8 bits per channel.
+		 */
+		void Begin(Vec2i Position, Vec2ui Size, Vec2ui WindowSize, bool HighPrecision);
+		void End();
+
+		/**
+		 * @brief
+		 * Draws the layer texture into the currently bound framebuffer.
+		 */
+		void Draw(Shader* LayerShader);
+
+		/**
+		 * @brief
+		 * Sets the blend mode for drawing into the window or the layer that is currently being drawn.
+		 */
+		static void ApplyBlendMode();
+
+	private:
+		unsigned int Framebuffer = 0, Texture = 0;
+		Vec2ui TextureSize;
+		bool TextureHighPrecision = false;
+		Vec2i Position;
+		Vec2ui WindowSize;
+
+		int PreviousFramebuffer = 0;
+		int PreviousViewport[4] = {};
+		int PreviousScissor[4] = {};
+
+		/// The number of layers that are currently being drawn. Layers can contain other layers.
+		static thread_local unsigned int ActiveLayers;
+	};
+}
@@ -0,0 +1,230 @@
+#include "Internal.h"
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KLEMMUI_UTF8_SSE2 1
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define KLEMMUI_UTF8_NEON 1
+#endif
+
+using namespace kui;
+
+constexpr char32_t UNICODE_REPLACEMENT_CHARACTER = 0xFFFD;
+// Number of bytes checked at once by the ASCII fast path.
+constexpr size_t UTF8_BLOCK_SIZE = 16;
+
+/*
+* Decodes a single character. Returns the number of bytes it uses.
+* Invalid sequences decode to U+FFFD and use a single byte, so decoding continues at the next byte.
+*/
+static size_t DecodeCharacter(const uint8_t* Bytes, size_t Length, char32_t& OutCharacter)
+{
+	uint8_t ch = Bytes[0];
+	size_t Todo = 0;
+	char32_t Min = 0;
+	OutCharacter = UNICODE_REPLACEMENT_CHARACTER;
+
+	if (ch <= 0x7F)
+	{
+		OutCharacter = ch;
+		return 1;
+	}
+	// 0x80 - 0xBF are continuation bytes, 0xC0 and 0xC1 could only start an overlong sequence.
+	else if (ch < 0xC2)
+	{
+		return 1;
+	}
+	else if (ch <= 0xDF)
+	{
+		OutCharacter = ch & 0x1F;
+		Todo = 1;
+		Min = 0x80;
+	}
+	else if (ch <= 0xEF)
+	{
+		OutCharacter = ch & 0x0F;
+		Todo = 2;
+		Min = 0x800;
+	}
+	else if (ch <= 0xF4)
+	{
+		OutCharacter = ch & 0x07;
+		Todo = 3;
+		Min = 0x10000;
+	}
+	else
+	{
+		return 1;
+	}
+
+	if (Todo >= Length)
+	{
+		OutCharacter = UNICODE_REPLACEMENT_CHARACTER;
+		return 1;
+	}
+	for (size_t i = 1; i <= Todo; i++)
+	{
+		if ((Bytes[i] & 0xC0) != 0x80)
+		{
+			OutCharacter = UNICODE_REPLACEMENT_CHARACTER;
+			return 1;
+		}
+		OutCharacter = (OutCharacter << 6) | (Bytes[i] & 0x3F);
+	}
+	if (OutCharacter < Min
+		|| (OutCharacter >= 0xD800 && OutCharacter <= 0xDFFF)
+		|| OutCharacter > 0x10FFFF)
+	{
+		OutCharacter = UNICODE_REPLACEMENT_CHARACTER;
+		return 1;
+	}
+	return Todo + 1;
+}
+
+/*
+* Converts whole blocks of ASCII characters at the start of Bytes.
+* Returns the number of converted bytes, which stops at the first block containing a non-ASCII byte.
+*/
+static size_t DecodeAscii(const uint8_t* Bytes, size_t Length, char32_t* Out, uint32_t* OutOffsets, uint32_t FirstOffset)
+{
+	size_t i = 0;
+#if KLEMMUI_UTF8_SSE2
+	const __m128i Zero = _mm_setzero_si128();
+	const __m128i Four = _mm_set1_epi32(4);
+	for (; i + UTF8_BLOCK_SIZE <= Length; i += UTF8_BLOCK_SIZE)
+	{
+		__m128i Chunk = _mm_loadu_si128((const __m128i*)(Bytes + i));
+		// The sign bit is set for every byte that isn't ASCII.
+		if (_mm_movemask_epi8(Chunk))
+		{
+			break;
+		}
+		__m128i Low = _mm_unpacklo_epi8(Chunk, Zero);
+		__m128i High = _mm_unpackhi_epi8(Chunk, Zero);
+		_mm_storeu_si128((__m128i*)(Out + i), _mm_unpacklo_epi16(Low, Zero));
+		_mm_storeu_si128((__m128i*)(Out + i + 4), _mm_unpackhi_epi16(Low, Zero));
+		_mm_storeu_si128((__m128i*)(Out + i + 8), _mm_unpacklo_epi16(High, Zero));
+		_mm_storeu_si128((__m128i*)(Out + i + 12), _mm_unpackhi_epi16(High, Zero));
+
+		if (OutOffsets)
+		{
+			__m128i Offsets = _mm_add_epi32(_mm_set1_epi32(int(FirstOffset + i)), _mm_setr_epi32(0, 1, 2, 3));
+			for (size_t j = 0; j < UTF8_BLOCK_SIZE; j += 4)
+			{
+				_mm_storeu_si128((__m128i*)(OutOffsets + i + j), Offsets);
+				Offsets = _mm_add_epi32(Offsets, Four);
+			}
+		}
+	}
+#elif KLEMMUI_UTF8_NEON
+	const uint32_t Steps[4] = { 0, 1, 2, 3 };
+	const uint32x4_t StepVector = vld1q_u32(Steps);
+	for (; i + UTF8_BLOCK_SIZE <= Length; i += UTF8_BLOCK_SIZE)
+	{
+		uint8x16_t Chunk = vld1q_u8(Bytes + i);
+		if (vmaxvq_u8(Chunk) >= 0x80)
+		{
+			break;
+		}
+		uint16x8_t Low = vmovl_u8(vget_low_u8(Chunk));
+		uint16x8_t High = vmovl_u8(vget_high_u8(Chunk));
+		vst1q_u32((uint32_t*)(Out + i), vmovl_u16(vget_low_u16(Low)));
+		vst1q_u32((uint32_t*)(Out + i + 4), vmovl_u16(vget_high_u16(Low)));
+		vst1q_u32((uint32_t*)(Out + i + 8), vmovl_u16(vget_low_u16(High)));
+		vst1q_u32((uint32_t*)(Out + i + 12), vmovl_u16(vget_high_u16(High)));
+
+		if (OutOffsets)
+		{
+			for (size_t j = 0; j < UTF8_BLOCK_SIZE; j += 4)
+			{
+				vst1q_u32(OutOffsets + i + j, vaddq_u32(vdupq_n_u32(uint32_t(FirstOffset + i + j)), StepVector));
+			}
+		}
+	}
+#endif
+	return i;
+}
+
+void kui::internal::DecodeUTF8(std::string_view utf8, std::u32string& OutCharacters, std::vector<uint32_t>* OutByteOffsets)
+{
+	const uint8_t* Bytes = (const uint8_t*)utf8.data();
+	size_t Length = utf8.size();
+
+	// There can't be more characters than bytes, the buffers are shrunk to the right size in the end.
+	OutCharacters.resize(Length);
+	if (OutByteOffsets)
+	{
+		OutByteOffsets->resize(Length + 1);
+	}
+	char32_t* Out = OutCharacters.data();
+	uint32_t* Offsets = OutByteOffsets ? OutByteOffsets->data() : nullptr;
+
+	size_t i = 0;
+	size_t NumCharacters = 0;
+	while (i < Length)
+	{
+		size_t NumAscii = DecodeAscii(Bytes + i, Length - i, Out + NumCharacters, Offsets ? Offsets + NumCharacters : nullptr, uint32_t(i));
+		i += NumAscii;
+		NumCharacters += NumAscii;
+
+		// Decode the block that stopped the fast path one character at a time.
+		size_t BlockEnd = std::min(i + UTF8_BLOCK_SIZE, Length);
+		while (i < BlockEnd)
+		{
+			if (Offsets)
+			{
+				Offsets[NumCharacters] = uint32_t(i);
+			}
+			i += DecodeCharacter(Bytes + i, Length - i, Out[NumCharacters]);
+			NumCharacters++;
+		}
+	}
+
+	OutCharacters.resize(NumCharacters);
+	if (OutByteOffsets)
+	{
+		(*OutByteOffsets)[NumCharacters] = uint32_t(Length);
+		OutByteOffsets->resize(NumCharacters + 1);
+	}
+}
+
+void kui::internal::DecodeUTF8Scalar(std::string_view utf8, std::u32string& OutCharacters, std::vector<uint32_t>* OutByteOffsets)
+{
+	const uint8_t* Bytes = (const uint8_t*)utf8.data();
+	size_t Length = utf8.size();
+
+	OutCharacters.resize(Length);
+	if (OutByteOffsets)
+	{
+		OutByteOffsets->resize(Length + 1);
+	}
+
+	size_t i = 0;
+	size_t NumCharacters = 0;
+	while (i < Length)
+	{
+		if (OutByteOffsets)
+		{
+			(*OutByteOffsets)[NumCharacters] = uint32_t(i);
+		}
+		i += DecodeCharacter(Bytes + i, Length - i, OutCharacters[NumCharacters]);
+		NumCharacters++;
+	}
+
+	OutCharacters.resize(NumCharacters);
+	if (OutByteOffsets)
+	{
+		(*OutByteOffsets)[NumCharacters] = uint32_t(Length);
+		OutByteOffsets->resize(NumCharacters + 1);
+	}
+}
+
+std::u32string kui::internal::GetUnicodeString(const std::string& utf8)
+{
+	std::u32string Result;
+	DecodeUTF8(utf8, Result, nullptr);
+	return Result;
+}
\ No newline at end of file
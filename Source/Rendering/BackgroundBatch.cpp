@@ -0,0 +1,111 @@
+#include "BackgroundBatch.h"
+#include "VertexBuffer.h"
+#include "../Internal/OpenGL.h"
+#include <kui/Rendering/Shader.h>
+#include <kui/Window.h>
+#include <cstddef>
+using namespace kui;
+
+static_assert(sizeof(BackgroundInstance) == sizeof(float) * 20, "BackgroundInstance must not contain padding");
+
+BackgroundBatch::BackgroundBatch()
+{
+	const Vertex Vertices[] = {
+		Vertex(Vec2f(0, 0), 0),
+		Vertex(Vec2f(0, 1), 1),
+		Vertex(Vec2f(1, 0), 2),
+		Vertex(Vec2f(1, 1), 3)
+	};
+	const unsigned int Indices[] = {
+		0u, 1u, 2u,
+		1u, 2u, 3u
+	};
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glGenBuffers(1, &EBO);
+	glGenBuffers(1, &InstanceBuffer);
+	glBindVertexArray(VAO);
+
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertices), Vertices, GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(Indices), Indices, GL_STATIC_DRAW);
+
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Position));
+
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, CornerIndex));
+
+	// Attributes 2 - 6 are one vec4 each, advanced once per instance.
+	glBindBuffer(GL_ARRAY_BUFFER, InstanceBuffer);
+	for (unsigned int i = 0; i < 5; i++)
+	{
+		glEnableVertexAttribArray(2 + i);
+		glVertexAttribPointer(2 + i, 4, GL_FLOAT, GL_FALSE, sizeof(BackgroundInstance), (void*)(sizeof(float) * 4 * i));
+		glVertexAttribDivisor(2 + i, 1);
+	}
+
+	glBindVertexArray(0);
+}
+
+BackgroundBatch::~BackgroundBatch()
+{
+	glDeleteVertexArrays(1, &VAO);
+	glDeleteBuffers(1, &VBO);
+	glDeleteBuffers(1, &EBO);
+	glDeleteBuffers(1, &InstanceBuffer);
+}
+
+void BackgroundBatch::Add(const BackgroundInstance& Instance, Shader* UsedShader, bool UseTexture, unsigned int TextureID)
+{
+	if (!Instances.empty()
+		&& (UsedShader != BatchShader || UseTexture != BatchUseTexture || (UseTexture && TextureID != BatchTexture)))
+	{
+		Flush();
+	}
+	BatchShader = UsedShader;
+	BatchUseTexture = UseTexture;
+	BatchTexture = TextureID;
+	Instances.push_back(Instance);
+}
+
+void BackgroundBatch::Flush()
+{
+	if (Instances.empty())
+	{
+		return;
+	}
+
+	Window* Win = Window::GetActiveWindow();
+
+	BatchShader->Bind();
+	BatchShader->SetInt("u_instanced", 1);
+	BatchShader->SetInt("u_useTexture", (int)BatchUseTexture);
+	BatchShader->SetFloat("u_aspectRatio", Win->GetAspectRatio());
+	BatchShader->SetVec2("u_screenRes", Vec2f(
+		(float)Win->GetSize().X,
+		(float)Win->GetSize().Y));
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, BatchTexture);
+
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, InstanceBuffer);
+	size_t DataSize = Instances.size() * sizeof(BackgroundInstance);
+	if (DataSize > InstanceBufferSize)
+	{
+		InstanceBufferSize = DataSize * 2;
+	}
+	// Orphan the old buffer, so the driver doesn't have to wait for previous draws using it.
+	glBufferData(GL_ARRAY_BUFFER, InstanceBufferSize, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, DataSize, Instances.data());
+
+	glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, (GLsizei)Instances.size());
+	glBindVertexArray(0);
+
+	// The same shader is also used for drawing single boxes with uniforms.
+	BatchShader->SetInt("u_instanced", 0);
+	Instances.clear();
+}
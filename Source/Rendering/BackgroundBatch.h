@@ -0,0 +1,58 @@
+#pragma once
+#include <vector>
+#include <kui/Vec2.h>
+#include <kui/Vec3.h>
+
+namespace kui
+{
+	class Shader;
+
+	/**
+	 * @brief
+	 * Per-instance data of a batched background. Matches the instance attributes of uishader.vert.
+	 */
+	struct BackgroundInstance
+	{
+		Vec2f Position;
+		Vec2f Size;
+		Vec3f Color;
+		float Opacity = 1;
+		Vec3f BorderColor;
+		float BorderScale = 0;
+		Vec3f ScrollOffset;
+		float CornerScale = 0;
+		float DrawBorder = 0;
+		float DrawCorner = 0;
+		float CornerFlags = 0;
+		float BorderFlags = 0;
+	};
+
+	/**
+	 * @brief
+	 * Collects background quads and draws them with a single instanced draw call.
+	 *
+	 * Boxes are drawn in the order they were added. The batch has to be flushed before anything else is drawn,
+	 * so boxes drawn later still appear on top.
+	 */
+	struct BackgroundBatch
+	{
+		BackgroundBatch();
+		~BackgroundBatch();
+
+		/**
+		 * @brief
+		 * Adds a box to the batch. Flushes the batch first if the box uses a different shader or texture.
+		 */
+		void Add(const BackgroundInstance& Instance, Shader* UsedShader, bool UseTexture, unsigned int TextureID);
+		void Flush();
+
+	private:
+		unsigned int VAO = 0u, VBO = 0u, EBO = 0u, InstanceBuffer = 0u;
+		size_t InstanceBufferSize = 0;
+		std::vector<BackgroundInstance> Instances;
+
+		Shader* BatchShader = nullptr;
+		bool BatchUseTexture = false;
+		unsigned int BatchTexture = 0;
+	};
+}
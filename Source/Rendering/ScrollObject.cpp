@@ -69,6 +69,7 @@ void ScrollObject::ScrollUp()
 
 	Scrolled = std::min(Scrolled, MaxScroll);
 
+	Window::GetActiveWindow()->UI.InvalidateHoveredBox();
 	Window::GetActiveWindow()->UI.RedrawArea(UIManager::RedrawBox{
 		.Min = Position,
 		.Max = Position + Scale,
@@ -87,6 +88,7 @@ void ScrollObject::ScrollDown()
 	}
 	Scrolled = std::max(Scrolled, 0.0f);
 
+	Window::GetActiveWindow()->UI.InvalidateHoveredBox();
 	Window::GetActiveWindow()->UI.RedrawArea(UIManager::RedrawBox{
 		.Min = Position,
 		.Max = Position + Scale,
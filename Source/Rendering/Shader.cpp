@@ -137,3 +137,8 @@ void Shader::SetVec3(const std::string& Name, Vec3f Value)
 {
 	glUniform3f(GetUniformLocation(Name), Value.X, Value.Y, Value.Z);
 }
+
+void Shader::SetVec4(const std::string& Name, float X, float Y, float Z, float W)
+{
+	glUniform4f(GetUniformLocation(Name), X, Y, Z, W);
+}
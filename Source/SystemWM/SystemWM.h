@@ -9,6 +9,23 @@ namespace kui::systemWM
 	void DestroyWindow(SysWindow* Target);
 
 	void SwapWindow(SysWindow* Target);
+
+	/**
+	 * @brief
+	 * Swaps the window, telling the compositor that only the given rectangles have changed, if the platform supports it.
+	 *
+	 * @param Rects
+	 * X, Y, width and height of every rectangle in pixels, with the origin in the bottom left corner.
+	 */
+	void SwapWindowWithDamage(SysWindow* Target, const std::vector<int32_t>& Rects);
+
+	/**
+	 * @brief
+	 * Gets the number of frames since the current back buffer of the window was drawn.
+	 *
+	 * 0 if the contents of the back buffer are unknown, then the whole window has to be drawn again.
+	 */
+	int GetBufferAge(SysWindow* Target);
 	void ActivateContext(SysWindow* Target);
 
 	Vec2ui GetWindowSize(SysWindow* Target);
@@ -80,6 +80,30 @@ void kui::systemWM::SwapWindow(SysWindow* Target)
 		Target->X11->Swap();
 	}
 }
+
+void kui::systemWM::SwapWindowWithDamage(SysWindow* Target, [[maybe_unused]] const std::vector<int32_t>& Rects)
+{
+	if (GetUseWayland())
+	{
+		WAYLAND_FN(Target->Wayland->SwapWithDamage(Rects));
+	}
+	else
+	{
+		// GLX has no way to pass the damaged area to the compositor.
+		Target->X11->Swap();
+	}
+}
+
+int kui::systemWM::GetBufferAge(SysWindow* Target)
+{
+	if (GetUseWayland())
+	{
+#if KLEMMUI_WITH_WAYLAND
+		return Target->Wayland->GetBufferAge();
+#endif
+	}
+	return Target->X11->GetBufferAge();
+}
 void kui::systemWM::UpdateWindowFlags(SysWindow* Target, Window::WindowFlag NewFlags)
 {
 	if (GetUseWayland())
@@ -534,6 +534,30 @@ void kui::systemWM::WaylandWindow::Swap() const
 	eglSwapBuffers(GLDisplay, GLSurface);
 }
 
+void kui::systemWM::WaylandWindow::SwapWithDamage(const std::vector<int32_t>& Rects) const
+{
+	if (!SwapBuffersWithDamage || Rects.empty())
+	{
+		Swap();
+		return;
+	}
+	SwapBuffersWithDamage(GLDisplay, GLSurface, Rects.data(), EGLint(Rects.size() / 4));
+}
+
+int kui::systemWM::WaylandWindow::GetBufferAge() const
+{
+	if (!HasBufferAge || !GLSurface)
+	{
+		return 0;
+	}
+	EGLint Age = 0;
+	if (!eglQuerySurface(GLDisplay, GLSurface, EGL_BUFFER_AGE_EXT, &Age))
+	{
+		return 0;
+	}
+	return int(Age);
+}
+
 void kui::systemWM::WaylandWindow::Destroy()
 {
 	wlThreading::AwaitRunOnMainThread([this]()
@@ -966,6 +990,20 @@ void kui::systemWM::WaylandWindow::InitEGL()
 		app::error::Error("Cannot bind EGL API!", true);
 	}
 
+	const char* Extensions = eglQueryString(GLDisplay, EGL_EXTENSIONS);
+	if (Extensions)
+	{
+		HasBufferAge = strstr(Extensions, "EGL_EXT_buffer_age");
+		if (strstr(Extensions, "EGL_KHR_swap_buffers_with_damage"))
+		{
+			SwapBuffersWithDamage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+		}
+		else if (strstr(Extensions, "EGL_EXT_swap_buffers_with_damage"))
+		{
+			SwapBuffersWithDamage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+		}
+	}
+
 	EGLint NumConfig;
 	if (!eglChooseConfig(GLDisplay, ConfigAttributes, &GLConfig, 1, &NumConfig))
 	{
@@ -4,6 +4,7 @@
 #include "SystemWM_WaylandClipboard.h"
 #include <cstdint>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <wayland-client.h>
 #include <wayland-egl.h>
 #include <libdecor-0/libdecor.h>
@@ -122,6 +123,8 @@ namespace kui::systemWM
 
 		void UpdateWindow();
 		void Swap() const;
+		void SwapWithDamage(const std::vector<int32_t>& Rects) const;
+		int GetBufferAge() const;
 		void Destroy();
 		void SetTitle(std::string NewTitle) const;
 
@@ -146,6 +149,10 @@ namespace kui::systemWM
 		EGLContext GLContext;
 		EGLDisplay GLDisplay = nullptr;
 		EGLConfig GLConfig = nullptr;
+		/// eglSwapBuffersWithDamageKHR or eglSwapBuffersWithDamageEXT, if supported.
+		PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC SwapBuffersWithDamage = nullptr;
+		/// True if EGL_EXT_buffer_age is supported.
+		bool HasBufferAge = false;
 
 		wl_surface* WaylandSurface;
 		wl_egl_window* WaylandGLWindow;
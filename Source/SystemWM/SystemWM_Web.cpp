@@ -145,6 +145,16 @@ void kui::systemWM::SwapWindow(SysWindow* Target)
 	glfwSwapBuffers(Target->GLWindow);
 }
 
+void kui::systemWM::SwapWindowWithDamage(SysWindow* Target, const std::vector<int32_t>& Rects)
+{
+	SwapWindow(Target);
+}
+
+int kui::systemWM::GetBufferAge(SysWindow* Target)
+{
+	return 0;
+}
+
 void kui::systemWM::UpdateWindowFlags(SysWindow* Target, Window::WindowFlag NewFlags)
 {
 }
@@ -667,6 +667,16 @@ void kui::systemWM::SwapWindow(SysWindow* Target)
 	SwapBuffers(Target->DeviceContext);
 }
 
+void kui::systemWM::SwapWindowWithDamage(SysWindow* Target, const std::vector<int32_t>& Rects)
+{
+	SwapWindow(Target);
+}
+
+int kui::systemWM::GetBufferAge(SysWindow* Target)
+{
+	return 0;
+}
+
 void kui::systemWM::WaitFrame(SysWindow* Target, float RemainingTime)
 {
 	DwmFlush();
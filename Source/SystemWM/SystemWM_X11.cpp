@@ -359,6 +359,9 @@ void kui::systemWM::X11Window::Create(Window* Parent, Vec2ui Size, Vec2ui Pos, s
 	GLContext = glXCreateContext(XDisplay, GlxVisual, NULL, GL_TRUE);
 
 	MakeContextCurrent();
+
+	const char* Extensions = glXQueryExtensionsString(XDisplay, DefaultScreen(XDisplay));
+	HasBufferAge = Extensions && strstr(Extensions, "GLX_EXT_buffer_age");
 }
 
 void kui::systemWM::X11Window::Destroy()
@@ -449,6 +452,17 @@ void kui::systemWM::X11Window::Swap() const
 	glXSwapBuffers(XDisplay, XWindow);
 }
 
+int kui::systemWM::X11Window::GetBufferAge() const
+{
+	if (!HasBufferAge)
+	{
+		return 0;
+	}
+	unsigned int Age = 0;
+	glXQueryDrawable(XDisplay, XWindow, GLX_BACK_BUFFER_AGE_EXT, &Age);
+	return int(Age);
+}
+
 bool kui::systemWM::X11Window::IsLMBDown()
 {
 	return QueryPointer(nullptr) & Button1Mask;
@@ -25,6 +25,9 @@ namespace kui::systemWM
 		void UpdateWindow();
 
 		void Swap() const;
+		int GetBufferAge() const;
+		/// True if GLX_EXT_buffer_age is supported.
+		bool HasBufferAge = false;
 		thread_local static Display* XDisplay;
 		thread_local static ::Window XRootWindow;
 		thread_local static uint32_t OpenedWindows;
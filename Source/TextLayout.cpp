@@ -0,0 +1,473 @@
+#include <kui/TextLayout.h>
+#include <kui/Window.h>
+#include "Internal/Internal.h"
+#include <algorithm>
+using namespace kui;
+
+bool TextLayout::Update(Font* LayoutFont, const std::vector<TextSegment>& Text, float Scale, bool Wrapped, float LengthBeforeWrap, uint32_t MaxLines)
+{
+	float AspectRatio = Window::GetActiveWindow()->GetAspectRatio();
+	if (!Dirty
+		&& LayoutFont == this->LayoutFont
+		&& Scale == this->Scale
+		&& Wrapped == this->Wrapped
+		&& LengthBeforeWrap == this->LengthBeforeWrap
+		&& MaxLines == this->MaxLines
+		&& AspectRatio == this->AspectRatio)
+	{
+		return false;
+	}
+
+	this->LayoutFont = LayoutFont;
+	this->Scale = Scale;
+	this->Wrapped = Wrapped;
+	this->LengthBeforeWrap = LengthBeforeWrap;
+	this->MaxLines = MaxLines;
+	this->AspectRatio = AspectRatio;
+	Dirty = false;
+	Version++;
+	Build(Text);
+	AddChange(0, SIZE_MAX);
+	return true;
+}
+
+void TextLayout::Invalidate()
+{
+	Dirty = true;
+}
+
+void TextLayout::Edit(const std::vector<TextSegment>& Text, size_t Start, size_t RemovedLength, size_t InsertedLength)
+{
+	// Only a text made of a single segment without a line limit is updated in place. Anything else is laid out again.
+	if (Dirty
+		|| Text.size() != 1
+		|| MaxLines != UINT32_MAX
+		|| TextLength + InsertedLength - RemovedLength != Text[0].Text.size()
+		|| Start > TextLength)
+	{
+		Dirty = true;
+		return;
+	}
+
+	// Line breaks only depend on the text since the last new line, so only the lines of the edited paragraph change.
+	const std::string& Str = Text[0].Text;
+	size_t ParagraphStart = Start == 0 ? std::string::npos : Str.rfind('\n', Start - 1);
+	ParagraphStart = ParagraphStart == std::string::npos ? 0 : ParagraphStart + 1;
+	size_t NewStop = Str.find('\n', Start + InsertedLength);
+	NewStop = NewStop == std::string::npos ? Str.size() : NewStop + 1;
+	size_t OldStop = NewStop - InsertedLength + RemovedLength;
+	bool EditsLastLine = NewStop == Str.size();
+
+	// Both are the start of a paragraph, so they are the first character of a line.
+	size_t FirstOldLine = ParagraphStart < Characters.size() ? GetFirstLineStartingAt(ParagraphStart) : Lines.size() - 1;
+	size_t EndOldLine = OldStop < Characters.size() ? GetFirstLineStartingAt(OldStop) : Lines.size();
+	size_t FirstOldGlyph = Lines[FirstOldLine].FirstGlyph;
+	size_t EndOldGlyph = EndOldLine < Lines.size() ? Lines[EndOldLine].FirstGlyph : Glyphs.size();
+
+	std::vector<LayoutGlyph> NewGlyphs;
+	std::vector<Character> NewCharacters;
+	std::vector<Line> NewLines;
+	Vec2f NewEnd;
+	TextLength = Str.size();
+	LayoutLines(Text, ParagraphStart, NewStop, uint32_t(FirstOldLine), NewGlyphs, NewCharacters, NewLines, NewEnd);
+	if (EditsLastLine)
+	{
+		NewLines.back().EndCharacter = ParagraphStart + NewCharacters.size();
+		NewLines.back().CaretEnd = TextLength;
+		EndPosition = NewEnd;
+	}
+	else
+	{
+		// The last line starts after the paragraph and is already part of the layout.
+		NewLines.pop_back();
+	}
+
+	int64_t CharacterDelta = int64_t(InsertedLength) - int64_t(RemovedLength);
+	int64_t LineDelta = int64_t(NewLines.size()) - int64_t(EndOldLine - FirstOldLine);
+	int64_t GlyphDelta = int64_t(NewGlyphs.size()) - int64_t(EndOldGlyph - FirstOldGlyph);
+	float LineOffset = float(LineDelta) * CharacterSize;
+
+	for (Line& l : NewLines)
+	{
+		l.FirstGlyph += FirstOldGlyph;
+	}
+
+	// Everything after the paragraph only has to be moved. Characters don't store their line, so only the glyphs move.
+	if (LineDelta != 0)
+	{
+		for (size_t i = EndOldGlyph; i < Glyphs.size(); i++)
+		{
+			Glyphs[i].Position.Y += LineOffset;
+		}
+		if (!EditsLastLine)
+		{
+			EndPosition.Y += LineOffset;
+		}
+	}
+	for (size_t i = EndOldLine; i < Lines.size(); i++)
+	{
+		Lines[i].FirstCharacter += CharacterDelta;
+		Lines[i].EndCharacter += CharacterDelta;
+		Lines[i].CaretEnd += CharacterDelta;
+		Lines[i].FirstGlyph += GlyphDelta;
+	}
+
+	ReplaceRange(Characters, ParagraphStart, std::min(OldStop, Characters.size()), NewCharacters);
+	ReplaceRange(Glyphs, FirstOldGlyph, EndOldGlyph, NewGlyphs);
+	ReplaceRange(Lines, FirstOldLine, EndOldLine, NewLines);
+
+	MaxX = 0;
+	for (const Line& l : Lines)
+	{
+		MaxX = std::max(MaxX, l.Width);
+	}
+	Version++;
+	// If the number of lines changed, all lines after the paragraph have moved.
+	AddChange(FirstOldLine, LineDelta == 0 ? FirstOldLine + NewLines.size() : SIZE_MAX);
+}
+
+void TextLayout::SetColor(Vec3f NewColor)
+{
+	// A dirty layout takes the colors from the text segments when it is generated again.
+	if (Dirty)
+	{
+		return;
+	}
+	for (LayoutGlyph& g : Glyphs)
+	{
+		g.Color = NewColor;
+	}
+	Version++;
+	AddChange(0, SIZE_MAX);
+}
+
+template<typename T>
+void TextLayout::ReplaceRange(std::vector<T>& Target, size_t First, size_t End, const std::vector<T>& Replacement)
+{
+	// Overwrite the elements both ranges have in common, so the elements after them are only moved once.
+	size_t Common = std::min(End - First, Replacement.size());
+	std::copy(Replacement.begin(), Replacement.begin() + Common, Target.begin() + First);
+	if (Replacement.size() > Common)
+	{
+		Target.insert(Target.begin() + First + Common, Replacement.begin() + Common, Replacement.end());
+	}
+	else
+	{
+		Target.erase(Target.begin() + First + Common, Target.begin() + End);
+	}
+}
+
+size_t TextLayout::GetFirstLineStartingAt(size_t Index) const
+{
+	auto Found = std::lower_bound(Lines.begin(), Lines.end(), Index, [](const Line& l, size_t Index) {
+		return l.FirstCharacter < Index;
+	});
+	return size_t(Found - Lines.begin());
+}
+
+size_t TextLayout::GetLineOfCharacter(size_t Index) const
+{
+	// The last line starting at or before the character. Lines that wrapped before their first character are empty.
+	auto Found = std::upper_bound(Lines.begin(), Lines.end(), Index, [](size_t Index, const Line& l) {
+		return Index < l.FirstCharacter;
+	});
+	return Found == Lines.begin() ? 0 : size_t(Found - Lines.begin()) - 1;
+}
+
+void TextLayout::AddChange(size_t First, size_t End)
+{
+	constexpr size_t MAX_RECENT_CHANGES = 16;
+	if (RecentChanges.size() >= MAX_RECENT_CHANGES)
+	{
+		RecentChanges.erase(RecentChanges.begin());
+	}
+	RecentChanges.push_back(LineChange{ .First = First, .End = End });
+}
+
+void TextLayout::GetChangedLines(uint64_t SinceVersion, size_t& OutFirst, size_t& OutEnd) const
+{
+	OutFirst = 0;
+	OutEnd = 0;
+	if (SinceVersion == Version)
+	{
+		return;
+	}
+	if (SinceVersion > Version || Version - SinceVersion > RecentChanges.size())
+	{
+		OutEnd = SIZE_MAX;
+		return;
+	}
+	OutFirst = SIZE_MAX;
+	for (size_t i = RecentChanges.size() - (Version - SinceVersion); i < RecentChanges.size(); i++)
+	{
+		OutFirst = std::min(OutFirst, RecentChanges[i].First);
+		OutEnd = std::max(OutEnd, RecentChanges[i].End);
+	}
+}
+
+void TextLayout::Build(const std::vector<TextSegment>& Text)
+{
+	Glyphs.clear();
+	Characters.clear();
+	Lines.clear();
+	TextLength = 0;
+	for (const TextSegment& seg : Text)
+	{
+		TextLength += seg.Text.size();
+	}
+	Characters.reserve(TextLength);
+
+	LayoutLines(Text, 0, TextLength, 0, Glyphs, Characters, Lines, EndPosition);
+	Lines.back().EndCharacter = Characters.size();
+	Lines.back().CaretEnd = TextLength;
+
+	MaxX = 0;
+	for (const Line& l : Lines)
+	{
+		MaxX = std::max(MaxX, l.Width);
+	}
+}
+
+void TextLayout::LayoutLines(const std::vector<TextSegment>& Text, size_t StartIndex, size_t StopIndex, uint32_t FirstLine,
+	std::vector<LayoutGlyph>& OutGlyphs, std::vector<Character>& OutCharacters, std::vector<Line>& OutLines, Vec2f& OutEnd)
+{
+	LayoutFont->WaitForLoading();
+	CharacterSize = LayoutFont->CharacterSize;
+	float WrapLength = LengthBeforeWrap * AspectRatio / Scale;
+	float x = 0.f, y = float(FirstLine) * CharacterSize;
+	size_t CharIndex = StartIndex;
+	size_t TabCharIndex = 0;
+	size_t LastWrapCharIndex = 0;
+	uint32_t CurrentLine = FirstLine;
+	// The glyph index of the previous character on the same line, for kerning.
+	int PreviousGlyphIndex = 0;
+
+	OutLines.push_back(Line{ .FirstCharacter = StartIndex, .FirstGlyph = OutGlyphs.size() });
+
+	std::u32string SegmentText;
+	// The byte index of each character in SegmentText, relative to the start of the decoded part of the segment.
+	std::vector<uint32_t> ByteOffsets;
+	size_t SegmentStart = 0;
+	for (const TextSegment& seg : Text)
+	{
+		size_t SegmentEnd = SegmentStart + seg.Text.size();
+		if (SegmentEnd <= StartIndex || SegmentStart >= StopIndex)
+		{
+			SegmentStart = SegmentEnd;
+			continue;
+		}
+		size_t From = std::max(StartIndex, SegmentStart) - SegmentStart;
+		size_t To = std::min(StopIndex, SegmentEnd) - SegmentStart;
+		SegmentStart = SegmentEnd;
+
+		size_t LastWordIndex = SIZE_MAX;
+		size_t LastWrapIndex = 0;
+		size_t LastWordGlyph = 0;
+		internal::DecodeUTF8(std::string_view(seg.Text).substr(From, To - From), SegmentText, &ByteOffsets);
+		size_t SegmentFirstChar = SegmentStart - seg.Text.size() + From;
+		for (size_t i = 0; i < SegmentText.size(); i++, TabCharIndex++)
+		{
+			CharIndex = SegmentFirstChar + ByteOffsets[i];
+			if (CurrentLine > MaxLines)
+			{
+				break;
+			}
+			char32_t Char = SegmentText[i];
+			bool IsTab = Char == '\t';
+			if (IsTab)
+			{
+				Char = ' ';
+			}
+
+			float Advance = 0;
+			if (Char >= 32)
+			{
+				const Font::Glyph& CharGlyph = LayoutFont->GetGlyph(Char);
+				Advance = CharGlyph.TotalSize.X;
+				// Glyph index 0 is the missing glyph, which has no kerning.
+				x += LayoutFont->GetKerning(PreviousGlyphIndex, CharGlyph.GlyphIndex);
+				PreviousGlyphIndex = CharGlyph.GlyphIndex;
+
+				if (IsTab)
+				{
+					int Multiplier = (LayoutFont->TabSize - TabCharIndex % LayoutFont->TabSize);
+					Advance *= Multiplier;
+					TabCharIndex += Multiplier - 1;
+				}
+
+				if (Char == ' ')
+				{
+					LastWordIndex = i;
+					LastWrapCharIndex = CharIndex;
+					LastWordGlyph = OutGlyphs.size();
+				}
+
+				if (Wrapped && (x + Advance) / 450 > WrapLength)
+				{
+					CurrentLine++;
+					if (CurrentLine > MaxLines)
+					{
+						break;
+					}
+					float LineEndX = x;
+					x = 0;
+					y += CharacterSize;
+					if (LastWordIndex != SIZE_MAX && LastWordIndex != LastWrapIndex)
+					{
+						// Move everything after the last space to the next line.
+						i = LastWordIndex;
+						LastWrapIndex = i;
+						CharIndex = LastWrapCharIndex;
+						OutGlyphs.resize(LastWordGlyph);
+						if (OutCharacters.size() > CharIndex - StartIndex)
+						{
+							OutCharacters.resize(CharIndex - StartIndex + 1);
+						}
+						else
+						{
+							// The space itself didn't fit anymore.
+							OutCharacters.push_back(Character{
+								.X = LineEndX,
+								.Advance = Advance,
+								});
+						}
+						OutLines.back().EndCharacter = CharIndex + 1;
+						OutLines.back().CaretEnd = CharIndex;
+						OutLines.push_back(Line{ .FirstCharacter = CharIndex + 1, .FirstGlyph = OutGlyphs.size() });
+						PreviousGlyphIndex = 0;
+						continue;
+					}
+					OutLines.back().EndCharacter = CharIndex;
+					OutLines.back().CaretEnd = CharIndex;
+					OutLines.push_back(Line{ .FirstCharacter = CharIndex, .FirstGlyph = OutGlyphs.size() });
+				}
+				OutGlyphs.push_back(LayoutGlyph{
+					.Character = Char,
+					.Position = Vec2f(x, y),
+					.Color = seg.Color,
+					});
+			}
+
+			OutCharacters.push_back(Character{
+				.X = x,
+				.Advance = Advance,
+				});
+			x += Advance;
+			OutLines.back().Width = std::max(OutLines.back().Width, x);
+
+			// Every byte of a multi byte character gets an entry, so characters can be looked up by byte index.
+			for (size_t Byte = ByteOffsets[i] + 1; Byte < ByteOffsets[i + 1]; Byte++)
+			{
+				OutCharacters.push_back(Character{
+					.X = x,
+						.Continuation = true,
+					});
+			}
+
+			if (Char == '\n')
+			{
+				x = 0;
+				y += CharacterSize;
+				CurrentLine++;
+				OutLines.back().EndCharacter = CharIndex + 1;
+				OutLines.back().CaretEnd = CharIndex;
+				OutLines.push_back(Line{ .FirstCharacter = CharIndex + 1, .FirstGlyph = OutGlyphs.size() });
+				// A new line doesn't depend on the previous one, so it can be laid out on it's own when the text is edited.
+				LastWordIndex = SIZE_MAX;
+				TabCharIndex = SIZE_MAX;
+				PreviousGlyphIndex = 0;
+			}
+		}
+	}
+
+	OutEnd = Vec2f(x, y + CharacterSize);
+}
+
+Vec2f TextLayout::GetSize() const
+{
+	return Vec2f(MaxX / 450 / AspectRatio * Scale, EndPosition.Y / 450 * Scale);
+}
+
+Vec2f TextLayout::GetLetterLocation(size_t Index) const
+{
+	Vec2f Location = EndPosition;
+	if (Index < Characters.size())
+	{
+		Location = Vec2f(Characters[Index].X, float(GetLineOfCharacter(Index) + 1) * CharacterSize);
+	}
+	return Vec2f(Location.X / 450 / AspectRatio * Scale, Location.Y / 450 * Scale);
+}
+
+size_t TextLayout::GetCharacterAtPosition(Vec2f Position) const
+{
+	// The character size is 0 if the font failed to load.
+	if (Scale == 0 || CharacterSize == 0)
+	{
+		return 0;
+	}
+
+	// All lines have the same height, so the nearest line can be calculated directly.
+	float LineY = -Position.Y * 450 / Scale / CharacterSize;
+	size_t LineIndex = std::min(size_t(std::max(LineY, 0.0f)), Lines.size() - 1);
+	const Line& Nearest = Lines[LineIndex];
+
+	float X = Position.X * 450 * AspectRatio / Scale;
+
+	// The right edges of the characters in a line are sorted, so the first character ending after the position can be found with a binary search.
+	auto LineStart = Characters.begin() + Nearest.FirstCharacter;
+	auto LineEnd = Characters.begin() + Nearest.EndCharacter;
+	auto Found = std::partition_point(LineStart, LineEnd, [X](const Character& c) {
+		return c.X + c.Advance <= X;
+	});
+	// Characters without a width, like the continuation bytes of UTF-8 characters, can't be clicked.
+	while (Found != LineEnd && Found->Advance == 0)
+	{
+		Found++;
+	}
+	if (Found == LineEnd)
+	{
+		return std::min(Nearest.CaretEnd, TextLength);
+	}
+
+	size_t Index = size_t(Found - Characters.begin());
+	// Place the caret before the character if the position is on the left part of it.
+	if (Found->X + Found->Advance > X + Found->Advance * 450 / 800)
+	{
+		return Index;
+	}
+	size_t Next = Index + 1;
+	while (Next < Characters.size() && Characters[Next].Continuation)
+	{
+		Next++;
+	}
+	return std::min(Next, TextLength);
+}
+
+const std::vector<TextLayout::LayoutGlyph>& TextLayout::GetGlyphs() const
+{
+	return Glyphs;
+}
+
+float TextLayout::GetScale() const
+{
+	return Scale;
+}
+
+size_t TextLayout::GetLineCount() const
+{
+	return Lines.size();
+}
+
+size_t TextLayout::GetLineFirstGlyph(size_t Line) const
+{
+	if (Line >= Lines.size())
+	{
+		return Glyphs.size();
+	}
+	return Lines[Line].FirstGlyph;
+}
+
+uint64_t TextLayout::GetVersion() const
+{
+	return Version;
+}
@@ -1,26 +1,40 @@
 #include <kui/UI/UIBackground.h>
 #include "../Internal/OpenGL.h"
 #include "../Rendering/VertexBuffer.h"
+#include "../Rendering/BackgroundBatch.h"
 #include <kui/Rendering/Shader.h>
 #include <kui/App.h>
 #include <kui/UI/UIScrollBox.h>
+#include <kui/UI/UIButton.h>
+#include <kui/UI/UIDropdown.h>
+#include <kui/UI/UITextField.h>
 #include <kui/Window.h>
 #include <iostream>
+#include <typeinfo>
 using namespace kui;
 
 thread_local VertexBuffer* UIBackground::BoxVertexBuffer = nullptr;
+thread_local BackgroundBatch* UIBackground::Batch = nullptr;
 
 void UIBackground::ScrollTick(Shader* UsedShader)
+{
+	UsedShader->SetVec3("u_offset", GetScrollOffset());
+}
+
+Vec3f UIBackground::GetScrollOffset() const
 {
 	if (CurrentScrollObject != nullptr)
-		UsedShader->SetVec3("u_offset",
-			Vec3f(-CurrentScrollObject->GetOffset(), CurrentScrollObject->GetPosition().Y, CurrentScrollObject->GetScale().Y));
-	else
-		UsedShader->SetVec3("u_offset", Vec3f(0, -1000, 1000));
+		return Vec3f(-CurrentScrollObject->GetOffset(), CurrentScrollObject->GetPosition().Y, CurrentScrollObject->GetScale().Y);
+	return Vec3f(0, -1000, 1000);
 }
 
 void UIBackground::MakeGLBuffers()
 {
+	if (BoxVertexBuffer)
+	{
+		return;
+	}
+	Batch = new BackgroundBatch();
 	BoxVertexBuffer = new VertexBuffer(
 		{
 			Vertex(Vec2f(0, 0), 0),
@@ -79,6 +93,16 @@ void kui::UIBackground::FreeVertexBuffer()
 {
 	if (BoxVertexBuffer)
 		delete BoxVertexBuffer;
+	if (Batch)
+		delete Batch;
+	BoxVertexBuffer = nullptr;
+	Batch = nullptr;
+}
+
+void UIBackground::FlushBatch()
+{
+	if (Batch)
+		Batch->Flush();
 }
 
 UIBackground* UIBackground::SetOpacity(float NewOpacity)
@@ -222,14 +246,8 @@ UIBackground::UIBackground(bool Horizontal, Vec2f Position, Vec3f Color, SizeVec
 {
 	SetMinSize(MinScale);
 	this->Color = Color;
-	if (!UsedShader)
-	{
-		this->BackgroundShader = Window::GetActiveWindow()->Shaders.LoadShader("res:shaders/uishader.vert", "res:shaders/uishader.frag", "UI Shader");
-	}
-	else
-	{
-		this->BackgroundShader = UsedShader;
-	}
+	DefaultShader = Window::GetActiveWindow()->Shaders.LoadShader("res:shaders/uishader.vert", "res:shaders/uishader.frag", "UI Shader");
+	this->BackgroundShader = UsedShader ? UsedShader : DefaultShader;
 	MakeGLBuffers();
 }
 
@@ -248,13 +266,6 @@ void UIBackground::Draw()
 	{
 		return;
 	}
-	BackgroundShader->Bind();
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, TextureID);
-	BoxVertexBuffer->Bind();
-	ScrollTick(BackgroundShader);
-	BackgroundShader->SetVec3("u_color", Color);
-	BackgroundShader->SetVec3("u_borderColor", BorderColor);
 
 	UISize DrawnBorderRadius = BorderRadius;
 
@@ -270,7 +281,35 @@ void UIBackground::Draw()
 		}
 	}
 
-	glUniform4f(glGetUniformLocation(BackgroundShader->GetShaderID(), "u_transform"), OffsetPosition.X, OffsetPosition.Y, Size.X, Size.Y);
+	if (IsBatchedDraw())
+	{
+		Batch->Add(BackgroundInstance{
+			.Position = OffsetPosition,
+			.Size = Size,
+			.Color = Color,
+			.Opacity = Opacity,
+			.BorderColor = BorderColor,
+			.BorderScale = GetBorderSize(DrawnBorderRadius),
+			.ScrollOffset = GetScrollOffset(),
+			.CornerScale = GetBorderSize(CornerRadius),
+			.DrawBorder = DrawnBorderRadius.Value != 0 ? 1.0f : 0.0f,
+			.DrawCorner = CornerRadius.Value != 0 ? 1.0f : 0.0f,
+			.CornerFlags = float(CornerFlags),
+			.BorderFlags = float(BorderFlags),
+			}, BackgroundShader, UseTexture, TextureID);
+		DrawBackground();
+		return;
+	}
+
+	BackgroundShader->Bind();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, TextureID);
+	BoxVertexBuffer->Bind();
+	ScrollTick(BackgroundShader);
+	BackgroundShader->SetVec3("u_color", Color);
+	BackgroundShader->SetVec3("u_borderColor", BorderColor);
+
+	BackgroundShader->SetVec4("u_transform", OffsetPosition.X, OffsetPosition.Y, Size.X, Size.Y);
 	BackgroundShader->SetFloat("u_opacity", Opacity);
 	BackgroundShader->SetInt("u_drawBorder", DrawnBorderRadius.Value != 0);
 	BackgroundShader->SetInt("u_drawCorner", CornerRadius.Value != 0);
@@ -289,6 +328,19 @@ void UIBackground::Draw()
 	BoxVertexBuffer->Unbind();
 }
 
+bool UIBackground::IsBatchedDraw() const
+{
+	// A batched background is drawn at the next flush, so it would be painted over anything an unknown subclass
+	// draws in an overridden Draw() or DrawBackground(). UITextField flushes the batch before it draws.
+	const std::type_info& Type = typeid(*this);
+	if (Type != typeid(UIBackground) && Type != typeid(UIButton) && Type != typeid(UIDropdown) && Type != typeid(UITextField))
+	{
+		return false;
+	}
+	// BackgroundShader is public and might have been replaced after construction.
+	return BackgroundShader == DefaultShader;
+}
+
 void UIBackground::Update()
 {
 }
@@ -4,8 +4,8 @@
 #include "../Rendering/VertexBuffer.h"
 #include "../Internal/OpenGL.h"
 
-const float BlurScale = 0.2f;
-const int BlurAmount = 15;
+// The blurred image has half the resolution of the area behind the background.
+const float BlurScale = 0.5f;
 
 kui::Vec2ui kui::UIBlurBackground::GetPixelSize()
 {
@@ -15,26 +15,34 @@ kui::Vec2ui kui::UIBlurBackground::GetPixelSize()
 	), 1);
 }
 
+kui::Vec2ui kui::UIBlurBackground::GetLevelSize(unsigned int Level)
+{
+	return Vec2ui::Max(OldSize / Vec2ui(uint64_t(1) << Level), 1);
+}
+
 thread_local std::set<kui::UIBlurBackground*> kui::UIBlurBackground::BlurBackgrounds;
 
 void kui::UIBlurBackground::CreateBlurBuffers()
 {
 	if (BuffersLoaded)
 	{
-		glDeleteFramebuffers(2, BackgroundBuffers);
-		glDeleteTextures(2, BackgroundTextures);
+		glDeleteFramebuffers(BlurLevels, BackgroundBuffers);
+		glDeleteTextures(BlurLevels, BackgroundTextures);
 	}
 
-	const Vec2ui Size = GetPixelSize();
+	BuffersFormat = ParentWindow->UI.GetFramebufferFormat();
+	bool HighPrecision = BuffersFormat == UIManager::FramebufferFormat::RGBA16F;
 
-	glGenFramebuffers(2, BackgroundBuffers);
-	glGenTextures(2, BackgroundTextures);
-	for (unsigned int i = 0; i < 2; i++)
+	glGenFramebuffers(BlurLevels, BackgroundBuffers);
+	glGenTextures(BlurLevels, BackgroundTextures);
+	for (unsigned int i = 0; i < BlurLevels; i++)
 	{
+		const Vec2ui Size = GetLevelSize(i);
 		glBindFramebuffer(GL_FRAMEBUFFER, BackgroundBuffers[i]);
 		glBindTexture(GL_TEXTURE_2D, BackgroundTextures[i]);
 		glTexImage2D(
-			GL_TEXTURE_2D, 0, GL_RGBA16F, GLsizei(Size.X), GLsizei(Size.Y), 0, GL_RGBA, GL_FLOAT, NULL
+			GL_TEXTURE_2D, 0, HighPrecision ? GL_RGBA16F : GL_RGBA8, GLsizei(Size.X), GLsizei(Size.Y), 0,
+			GL_RGBA, HighPrecision ? GL_FLOAT : GL_UNSIGNED_BYTE, NULL
 		);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -47,16 +55,63 @@ void kui::UIBlurBackground::CreateBlurBuffers()
 	BuffersLoaded = true;
 }
 
+void kui::UIBlurBackground::BlurBehind()
+{
+	glDisable(GL_SCISSOR_TEST);
+	glActiveTexture(GL_TEXTURE0);
+	BlurShader->Bind();
+
+	// Downsample the area behind this background into smaller and smaller textures...
+	BlurShader->SetInt("u_upsample", 0);
+	for (unsigned int i = 0; i < BlurLevels; i++)
+	{
+		const Vec2ui LevelSize = GetLevelSize(i);
+		glBindFramebuffer(GL_FRAMEBUFFER, BackgroundBuffers[i]);
+		glViewport(0, 0, (GLsizei)LevelSize.X, (GLsizei)LevelSize.Y);
+		if (i == 0)
+		{
+			// The first pass samples the UI texture, which can be larger than the window.
+			const Vec2f UVScale = ParentWindow->UI.GetFramebufferUVScale();
+			BlurShader->SetVec2("u_scale", Size / 2 * UVScale);
+			BlurShader->SetVec2("u_position", (OffsetPosition + 1) / 2 * UVScale);
+			glBindTexture(GL_TEXTURE_2D, ParentWindow->UI.UITextures[0]);
+		}
+		else
+		{
+			BlurShader->SetVec2("u_scale", 1);
+			BlurShader->SetVec2("u_position", 0);
+			glBindTexture(GL_TEXTURE_2D, BackgroundTextures[i - 1]);
+		}
+		BoxVertexBuffer->Draw();
+	}
+
+	// ...then upsample them again, until the largest texture contains the blurred image.
+	BlurShader->SetInt("u_upsample", 1);
+	for (unsigned int i = BlurLevels - 1; i > 0; i--)
+	{
+		const Vec2ui LevelSize = GetLevelSize(i - 1);
+		glBindFramebuffer(GL_FRAMEBUFFER, BackgroundBuffers[i - 1]);
+		glViewport(0, 0, (GLsizei)LevelSize.X, (GLsizei)LevelSize.Y);
+		glBindTexture(GL_TEXTURE_2D, BackgroundTextures[i]);
+		BoxVertexBuffer->Draw();
+	}
+	BlurShader->Unbind();
+	glEnable(GL_SCISSOR_TEST);
+	BlurDirty = false;
+	BlurredBox = GetRedrawBox();
+}
+
 kui::UIBlurBackground::UIBlurBackground(bool Horizontal, Vec2f Position, Vec3f Color, float Opacity, SizeVec MinScale)
 	: UIBackground(Horizontal, Position, Color, MinScale, Window::GetActiveWindow()->Shaders.LoadShader(
 		"res:shaders/uishader.vert",
 		"res:shaders/blursurface.frag",
 		"blur background shader"))
 {
-	BackgroundBuffers[0] = 0;
-	BackgroundBuffers[1] = 0;
-	BackgroundTextures[0] = 0;
-	BackgroundTextures[1] = 0;
+	for (unsigned int i = 0; i < BlurLevels; i++)
+	{
+		BackgroundBuffers[i] = 0;
+		BackgroundTextures[i] = 0;
+	}
 	this->Opacity = Opacity;
 	BlurShader = Window::GetActiveWindow()->Shaders.LoadShader(
 		"res:shaders/uiblur.vert",
@@ -64,14 +119,16 @@ kui::UIBlurBackground::UIBlurBackground(bool Horizontal, Vec2f Position, Vec3f C
 		"UI blurring shader"
 	);
 	BlurBackgrounds.insert(this);
+	// Not attached to a parent yet, so only this box contains the background.
+	BlurBackgroundsInside = 1;
 }
 
 kui::UIBlurBackground::~UIBlurBackground()
 {
 	if (BuffersLoaded)
 	{
-		glDeleteFramebuffers(2, BackgroundBuffers);
-		glDeleteTextures(2, BackgroundTextures);
+		glDeleteFramebuffers(BlurLevels, BackgroundBuffers);
+		glDeleteTextures(BlurLevels, BackgroundTextures);
 	}
 	BlurBackgrounds.erase(this);
 }
@@ -85,39 +142,23 @@ void kui::UIBlurBackground::Draw()
 	Vec2ui WindowSize = ParentWindow->GetSize();
 	const Vec2ui PixelSize = GetPixelSize();
 
-	if (OldSize != PixelSize)
+	if (OldSize != PixelSize || BuffersFormat != ParentWindow->UI.GetFramebufferFormat())
 	{
 		OldSize = PixelSize;
 		CreateBlurBuffers();
+		BlurDirty = true;
 	}
-	glViewport(0, 0, (GLsizei)PixelSize.X, (GLsizei)PixelSize.Y);
-	glDisable(GL_SCISSOR_TEST);
-	glActiveTexture(GL_TEXTURE0);
-
-	bool Horizontal = true, FirstIteration = true;
-	BlurShader->Bind();
-	BlurShader->SetVec2("u_scale", Size / 2);
-	BlurShader->SetVec2("u_position", (OffsetPosition + 1) / 2);
-
-	for (unsigned int i = 0; i < BlurAmount; i++)
+	if (BlurDirty)
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, BackgroundBuffers[Horizontal]);
-		BlurShader->SetInt("u_horizontal", Horizontal);
-		glClear(GL_COLOR_BUFFER_BIT);
-		glBindTexture(
-			GL_TEXTURE_2D, FirstIteration ? ParentWindow->UI.UITextures[0] : BackgroundTextures[!Horizontal]
-		);
-		BoxVertexBuffer->Draw();
-		BlurShader->SetVec2("u_scale", 1);
-		BlurShader->SetVec2("u_position", 0);
-		Horizontal = !Horizontal;
-		if (FirstIteration)
-			FirstIteration = false;
+		// Blurring uses its own framebuffers, so the current one is restored afterwards.
+		GLint PreviousFramebuffer = 0;
+		GLint PreviousViewport[4] = {};
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &PreviousFramebuffer);
+		glGetIntegerv(GL_VIEWPORT, PreviousViewport);
+		BlurBehind();
+		glViewport(PreviousViewport[0], PreviousViewport[1], PreviousViewport[2], PreviousViewport[3]);
+		glBindFramebuffer(GL_FRAMEBUFFER, GLuint(PreviousFramebuffer));
 	}
-	BlurShader->Unbind();
-	glViewport(0, 0, (GLsizei)WindowSize.X, (GLsizei)WindowSize.Y);
-	glBindFramebuffer(GL_FRAMEBUFFER, ParentWindow->UI.UIBuffer);
-	glEnable(GL_SCISSOR_TEST);
 
 	BackgroundShader->Bind();
 
@@ -132,7 +173,7 @@ void kui::UIBlurBackground::Draw()
 	const Vec2f Pos = Vec2f(Vec2i(OffsetPosition * WindowSize)) / WindowSize;
 	const Vec2f Res = Vec2f(Vec2i(Size * WindowSize)) / WindowSize;
 
-	glUniform4f(glGetUniformLocation(BackgroundShader->GetShaderID(), "u_transform"), Pos.X, Pos.Y, Res.X, Res.Y);
+	BackgroundShader->SetVec4("u_transform", Pos.X, Pos.Y, Res.X, Res.Y);
 	BackgroundShader->SetFloat("u_opacity", Opacity);
 	BackgroundShader->SetInt("u_drawBorder", BorderRadius.Value != 0);
 	BackgroundShader->SetInt("u_drawCorner", CornerRadius.Value != 0);
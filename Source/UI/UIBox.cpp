@@ -4,8 +4,13 @@
 #include <kui/App.h>
 #include <kui/Input.h>
 #include "../Internal/MathHelpers.h"
+#include "../Internal/LayerCache.h"
+#include "../Internal/HoverIndex.h"
 #include <kui/UI/UIScrollBox.h>
+#include <kui/UI/UIBackground.h>
 #include <cmath>
+#include <algorithm>
+#include <typeinfo>
 #include <kui/Window.h>
 using namespace kui;
 
@@ -45,47 +50,66 @@ UIBox::UIBox(bool Horizontal, Vec2f Position)
 	this->Position = Position;
 	this->ChildrenHorizontal = Horizontal;
 	ParentWindow = Window::GetActiveWindow();
+	ElementIndex = ParentWindow->UI.UIElements.size();
 	ParentWindow->UI.UIElements.push_back(this);
+	ParentWindow->UI.AddRoot(this);
 }
 
 UIBox::~UIBox()
 {
-	InvalidateLayout();
+	// If the parent is being destroyed too, it takes care of the layout and redrawing.
+	bool DestroyedWithParent = Parent && Parent->IsBeingDestroyed;
+	IsBeingDestroyed = true;
+
+	if (!DestroyedWithParent)
+	{
+		InvalidateLayout();
+	}
 	DeleteChildren();
-	if (ParentWindow->UI.HoveredBox == this)
+	SetTickEnabled(false);
+	if (Layer)
 	{
-		ParentWindow->UI.HoveredBox = nullptr;
+		std::vector<UIBox*>& LayerBoxes = ParentWindow->UI.LayerBoxes;
+		LayerBoxes.erase(std::find(LayerBoxes.begin(), LayerBoxes.end(), this));
+		delete Layer;
 	}
-	if (ParentWindow->UI.NewHoveredBox == this)
+	ParentWindow->UI.HoverBoxIndex->RemoveBox(this);
+	ParentWindow->UI.InvalidateHoveredBox();
+	if (ParentWindow->UI.HoveredBox == this)
 	{
-		ParentWindow->UI.NewHoveredBox = nullptr;
+		ParentWindow->UI.HoveredBox = nullptr;
 	}
 	if (ParentWindow->UI.KeyboardFocusBox == this)
 	{
 		ParentWindow->UI.KeyboardFocusBox = nullptr;
 	}
 
-	for (unsigned int i = 0; i < ParentWindow->UI.UIElements.size(); i++)
+	std::vector<UIBox*>& Elements = ParentWindow->UI.UIElements;
+	Elements[ElementIndex] = Elements.back();
+	Elements[ElementIndex]->ElementIndex = ElementIndex;
+	Elements.pop_back();
+
+	ParentWindow->UI.ElementsToUpdate.erase(this);
+	if (DestroyedWithParent)
 	{
-		if (ParentWindow->UI.UIElements[i] == this)
-		{
-			ParentWindow->UI.UIElements.erase(ParentWindow->UI.UIElements.begin() + i);
-		}
+		return;
 	}
-	ParentWindow->UI.ElementsToUpdate.erase(this);
 	if (Parent)
 	{
 		Parent->RedrawElement();
-		for (int i = 0; i < Parent->Children.size(); i++)
+		if (BlurBackgroundsInside)
 		{
-			if (Parent->Children[i] == this)
-			{
-				Parent->Children.erase(Parent->Children.begin() + i);
-			}
+			Parent->AddBlurBackgroundsInside(-int64_t(BlurBackgroundsInside));
+		}
+		auto Found = std::find(Parent->Children.begin(), Parent->Children.end(), this);
+		if (Found != Parent->Children.end())
+		{
+			Parent->Children.erase(Found);
 		}
 	}
 	else
 	{
+		ParentWindow->UI.RemoveRoot(this);
 		RedrawElement();
 	}
 }
@@ -100,11 +124,56 @@ void UIBox::Tick()
 
 void UIBox::UpdateTickState()
 {
-	for (auto c : Children)
+	ShouldBeTicked = VisibleInHierarchy;
+}
+
+void UIBox::UpdateVisibleInHierarchy()
+{
+	bool NewVisibleInHierarchy = Visible && (!Parent || Parent->VisibleInHierarchy);
+	if (NewVisibleInHierarchy == VisibleInHierarchy)
 	{
-		c->UpdateTickState();
+		return;
 	}
-	ShouldBeTicked = IsVisibleInHierarchy();
+	VisibleInHierarchy = NewVisibleInHierarchy;
+	UpdateTickState();
+
+	if (!VisibleInHierarchy && ParentWindow->UI.KeyboardFocusBox == this)
+	{
+		ParentWindow->UI.KeyboardFocusBox = nullptr;
+	}
+
+	for (UIBox* c : Children)
+	{
+		c->UpdateVisibleInHierarchy();
+	}
+}
+
+void UIBox::SetTickEnabled(bool NewTickEnabled)
+{
+	if (NewTickEnabled == GetTickEnabled())
+	{
+		return;
+	}
+
+	std::vector<UIBox*>& Ticked = ParentWindow->UI.TickedElements;
+	if (NewTickEnabled)
+	{
+		TickIndex = Ticked.size();
+		Ticked.push_back(this);
+	}
+	else
+	{
+		UIBox* Last = Ticked.back();
+		Ticked[TickIndex] = Last;
+		Last->TickIndex = TickIndex;
+		Ticked.pop_back();
+		TickIndex = SIZE_MAX;
+	}
+}
+
+bool UIBox::GetTickEnabled() const
+{
+	return TickIndex != SIZE_MAX;
 }
 
 UIBox* UIBox::GetParent()
@@ -119,15 +188,13 @@ Window* UIBox::GetParentWindow()
 
 void UIBox::MoveToFront()
 {
-	for (size_t i = 0; i < ParentWindow->UI.UIElements.size(); i++)
+	if (Parent)
 	{
-		if (ParentWindow->UI.UIElements[i] == this)
-		{
-			ParentWindow->UI.UIElements.erase(ParentWindow->UI.UIElements.begin() + i);
-			break;
-		}
+		return;
 	}
-	ParentWindow->UI.UIElements.push_back(this);
+	ParentWindow->UI.RemoveRoot(this);
+	ParentWindow->UI.AddRoot(this);
+	RedrawElement();
 }
 
 SizeVec UIBox::GetUsedSize()
@@ -149,7 +216,11 @@ void UIBox::SetCurrentScrollObject(UIScrollBox* s)
 
 void UIBox::SetCurrentScrollObject(ScrollObject* s)
 {
-	CurrentScrollObject = s;
+	if (s != CurrentScrollObject)
+	{
+		CurrentScrollObject = s;
+		UpdateHoverEntry();
+	}
 	for (auto& c : Children)
 	{
 		c->SetCurrentScrollObject(s);
@@ -160,12 +231,58 @@ void UIBox::OnAttached()
 {
 }
 
+UIBox* UIBox::SetVisible(bool NewVisible)
+{
+	if (NewVisible == Visible)
+	{
+		return this;
+	}
+	Visible = NewVisible;
+	UpdateVisibleInHierarchy();
+	// Also redraws the area if the box has just been hidden.
+	RedrawElement(true);
+	ParentWindow->UI.InvalidateHoveredBox();
+	return this;
+}
+
+bool UIBox::GetVisible() const
+{
+	return Visible;
+}
+
+UIBox* UIBox::SetLayerCached(bool NewLayerCached)
+{
+	if (NewLayerCached == GetLayerCached())
+	{
+		return this;
+	}
+	std::vector<UIBox*>& LayerBoxes = ParentWindow->UI.LayerBoxes;
+	if (NewLayerCached)
+	{
+		Layer = new internal::LayerCache();
+		LayerBoxes.push_back(this);
+	}
+	else
+	{
+		delete Layer;
+		Layer = nullptr;
+		LayerBoxes.erase(std::find(LayerBoxes.begin(), LayerBoxes.end(), this));
+	}
+	RedrawElement();
+	return this;
+}
+
+bool UIBox::GetLayerCached() const
+{
+	return Layer != nullptr;
+}
+
 UIBox* UIBox::SetMaxSize(SizeVec NewMaxSize)
 {
 	if (NewMaxSize != MaxSize)
 	{
 		MaxSize = NewMaxSize;
-		GetAbsoluteParent()->InvalidateLayout();
+		InvalidateLayout();
 	}
 	return this;
 }
@@ -180,7 +297,7 @@ UIBox* UIBox::SetMinSize(SizeVec NewMinSize)
 	if (NewMinSize != MinSize)
 	{
 		MinSize = NewMinSize;
-		GetAbsoluteParent()->InvalidateLayout();
+		InvalidateLayout();
 	}
 	return this;
 }
@@ -261,7 +378,7 @@ UIBox* UIBox::SetPadding(UISize Up, UISize Down, UISize Left, UISize Right)
 		DownPadding = Down;
 		LeftPadding = Left;
 		RightPadding = Right;
-		GetAbsoluteParent()->InvalidateLayout();
+		InvalidateLayout();
 	}
 	return this;
 }
@@ -274,7 +391,7 @@ UIBox* UIBox::SetPadding(UISize AllDirs)
 		DownPadding = AllDirs;
 		LeftPadding = AllDirs;
 		RightPadding = AllDirs;
-		GetAbsoluteParent()->InvalidateLayout();
+		InvalidateLayout();
 	}
 	return this;
 }
@@ -296,7 +413,7 @@ UIBox* UIBox::SetHorizontal(bool IsHorizontal)
 	if (IsHorizontal != ChildrenHorizontal)
 	{
 		ChildrenHorizontal = IsHorizontal;
-		GetAbsoluteParent()->InvalidateLayout();
+		InvalidateLayout();
 	}
 	return this;
 }
@@ -307,7 +424,10 @@ void UIBox::Update()
 
 void UIBox::UpdateSelfAndChildren()
 {
-	UpdateScale();
+	if (MeasureDirty)
+	{
+		UpdateScale();
+	}
 	UpdatePosition();
 
 	Update();
@@ -326,11 +446,19 @@ void kui::UIBox::SetOffsetPosition(Vec2f NewPos)
 	{
 		Vec2f ScreenPos = GetPosition();
 		OffsetPosition = NewPos;
+		ArrangeDirty = true;
 		Vec2f NewScreenPos = GetPosition();
+		Vec2f UsedSize = GetUsedSize().GetScreen();
+		// The old and new area are redrawn separately, not the whole path between them.
 		ParentWindow->UI.RedrawArea(UIManager::RedrawBox{
-			.Min = Vec2f::Min(ScreenPos, NewScreenPos),
-			.Max = Vec2f::Max(ScreenPos, NewScreenPos) + GetUsedSize().GetScreen(),
-			});
+			.Min = ScreenPos,
+			.Max = ScreenPos + UsedSize,
+			}, this);
+		ParentWindow->UI.RedrawArea(UIManager::RedrawBox{
+			.Min = NewScreenPos,
+			.Max = NewScreenPos + UsedSize,
+			}, this);
+		UpdateHoverEntry();
 	}
 }
 
@@ -377,12 +505,14 @@ float UIBox::GetHorizontalOffset()
 	return HorizontalOffset;
 }
 
-void UIBox::UpdateScale()
+bool UIBox::DependsOnParentSize() const
+{
+	return MinSize.X.Mode == SizeMode::ParentRelative || MinSize.Y.Mode == SizeMode::ParentRelative
+		|| MaxSize.X.Mode == SizeMode::ParentRelative || MaxSize.Y.Mode == SizeMode::ParentRelative;
+}
+
+Vec2f UIBox::MeasureSize() const
 {
-	for (auto c : Children)
-	{
-		c->UpdateScale();
-	}
 	Vec2f NewSize = 0;
 	for (auto c : Children)
 	{
@@ -439,21 +569,49 @@ void UIBox::UpdateScale()
 			ScreenMaxSize.Y = AvailableParentSize.Y * MaxSize.Y.Value;
 		}
 	}
-	
-	NewSize = NewSize.Clamp(ScreenMinSize, ScreenMaxSize);
 
-	if (NewSize != Size)
+	return NewSize.Clamp(ScreenMinSize, ScreenMaxSize);
+}
+
+bool UIBox::ApplySize(Vec2f NewSize)
+{
+	if (NewSize == Size)
 	{
-		ParentWindow->UI.RedrawArea(UIManager::RedrawBox{
-			.Min = GetPosition(),
-			.Max = GetPosition() + Vec2f::Max(Size, NewSize),
-			});
-		Size = NewSize;
+		return false;
 	}
+	ParentWindow->UI.RedrawArea(UIManager::RedrawBox{
+		.Min = GetPosition(),
+		.Max = GetPosition() + Vec2f::Max(Size, NewSize),
+		}, this);
+	Size = NewSize;
+	UpdateHoverEntry();
+	return true;
+}
+
+void UIBox::UpdateScale()
+{
+	// Bottom-up pass. Only children that have been invalidated need to be measured again,
+	// all other children still have a valid size from the last layout.
 	for (auto c : Children)
 	{
-		c->UpdateScale();
+		if (c->MeasureDirty)
+		{
+			c->UpdateScale();
+		}
 	}
+	ApplySize(MeasureSize());
+	MeasureDirty = false;
+	ArrangeDirty = true;
+}
+
+void UIBox::UpdateHoverEntry()
+{
+	if (IsBeingDestroyed)
+	{
+		return;
+	}
+	ParentWindow->UI.HoverBoxIndex->UpdateBox(this, OffsetPosition, Size, CurrentScrollObject);
+	ParentWindow->UI.InvalidateHoveredBox();
 }
 
 void UIBox::UpdatePosition()
@@ -465,6 +623,16 @@ void UIBox::UpdatePosition()
 		SetOffsetPosition(Position);
 	}
 
+	// Top-down pass. The size of children that are sized relative to this box
+	// can only be known once the size of this box has been measured.
+	for (auto c : Children)
+	{
+		if (c->DependsOnParentSize() && c->ApplySize(c->MeasureSize()))
+		{
+			c->ArrangeDirty = true;
+		}
+	}
+
 	Align PrimaryAlign = ChildrenHorizontal ? HorizontalBoxAlign : VerticalBoxAlign;
 
 	float ChildrenSize = 0;
@@ -527,9 +695,13 @@ void UIBox::UpdatePosition()
 	}
 	for (auto c : Children)
 	{
-		c->UpdatePosition();
-		c->Update();
+		if (c->ArrangeDirty)
+		{
+			c->UpdatePosition();
+			c->Update();
+		}
 	}
+	ArrangeDirty = false;
 }
 
 void UIBox::GetPaddingScreenSize(Vec2f& UpDown, Vec2f& LeftRight) const
@@ -549,7 +721,7 @@ void UIBox::RedrawElement(bool Force)
 	}
 
 	Redrawn = true;
-	ParentWindow->UI.RedrawArea(GetRedrawBox());
+	ParentWindow->UI.RedrawArea(GetRedrawBox(), this);
 }
 
 void kui::UIBox::SetUpPadding(UISize Value)
@@ -557,7 +729,7 @@ void kui::UIBox::SetUpPadding(UISize Value)
 	if (UpPadding != Value)
 	{
 		UpPadding = Value;
-		GetAbsoluteParent()->InvalidateLayout();
+		InvalidateLayout();
 	}
 }
 
@@ -566,7 +738,7 @@ void kui::UIBox::SetDownPadding(UISize Value)
 	if (DownPadding != Value)
 	{
 		DownPadding = Value;
-		GetAbsoluteParent()->InvalidateLayout();
+		InvalidateLayout();
 	}
 }
 
@@ -575,7 +747,7 @@ void kui::UIBox::SetLeftPadding(UISize Value)
 	if (LeftPadding != Value)
 	{
 		LeftPadding = Value;
-		GetAbsoluteParent()->InvalidateLayout();
+		InvalidateLayout();
 	}
 }
 
@@ -584,20 +756,37 @@ void kui::UIBox::SetRightPadding(UISize Value)
 	if (RightPadding != Value)
 	{
 		RightPadding = Value;
-		GetAbsoluteParent()->InvalidateLayout();
+		InvalidateLayout();
 	}
 }
 
 void UIBox::InvalidateLayout()
 {
-	if (Parent)
+	UIBox* Current = this;
+	Current->MeasureDirty = true;
+	while (Current->Parent)
 	{
-		Parent->InvalidateLayout();
-	}
-	else
-	{
-		ParentWindow->UI.ElementsToUpdate.insert(this);
+		Current = Current->Parent;
+		Current->MeasureDirty = true;
+
+		// The size of a layout boundary can't change because of its children,
+		// so the layout of the boxes above it is still valid.
+		if (Current->IsLayoutBoundary())
+		{
+			break;
+		}
 	}
+	ParentWindow->UI.ElementsToUpdate.insert(Current);
+}
+
+bool UIBox::IsLayoutBoundary() const
+{
+	return MinSize == MaxSize;
+}
+
+void UIBox::AssignSiblingOrder()
+{
+	SiblingOrder = ParentWindow->UI.NextSiblingOrder++;
 }
 
 UIBox* UIBox::AddChild(UIBox* NewChild)
@@ -609,10 +798,17 @@ UIBox* UIBox::AddChild(UIBox* NewChild)
 
 	if (!NewChild->Parent)
 	{
+		ParentWindow->UI.RemoveRoot(NewChild);
 		NewChild->Parent = this;
 		Children.push_back(NewChild);
+		NewChild->AssignSiblingOrder();
+		if (NewChild->BlurBackgroundsInside)
+		{
+			AddBlurBackgroundsInside(int64_t(NewChild->BlurBackgroundsInside));
+		}
 		NewChild->OnAttached();
-		InvalidateLayout();
+		NewChild->UpdateVisibleInHierarchy();
+		NewChild->InvalidateLayout();
 	}
 	else
 	{
@@ -629,32 +825,29 @@ UIBox* UIBox::GetAbsoluteParent()
 	}
 	return this;
 }
-void UIBox::UpdateHoveredState()
+void UIBox::DrawThisAndChildren(const UIManager::RedrawBox& Box)
 {
-	if (IsBeingHovered() && HasMouseCollision && IsVisibleInHierarchy())
+	LastDrawIndex++;
+	if (Layer && LayerContainsBlur())
 	{
-		ParentWindow->UI.NewHoveredBox = this;
+		// The layer isn't used, so it isn't updated when something inside of it changes.
+		Layer->Dirty = true;
 	}
-	for (UIBox* Child : Children)
+	if (Visible && Layer && !LayerContainsBlur())
 	{
-		Child->UpdateHoveredState();
+		DrawLayer(Box);
 	}
-}
-
-void UIBox::DrawThisAndChildren(const UIManager::RedrawBox& Box)
-{
-	for (auto c : Children)
-	{
-		c->UpdateTickState();
-	}
-	LastDrawIndex++;
-	if (IsVisible)
+	else if (Visible)
 	{
 		if (UIManager::RedrawBox::IsBoxOverlapping(Box, UIManager::RedrawBox{
 			.Min = GetPosition(),
 			.Max = GetPosition() + Size
 			}))
 		{
+			if (!IsBatchedDraw())
+			{
+				UIBackground::FlushBatch();
+			}
 			Draw();
 		}
 		for (auto c : Children)
@@ -665,20 +858,112 @@ void UIBox::DrawThisAndChildren(const UIManager::RedrawBox& Box)
 	Redrawn = false;
 }
 
+bool UIBox::IsBatchedDraw() const
+{
+	// UIBox::Draw() doesn't draw anything, but an unknown subclass might have overridden it.
+	return typeid(*this) == typeid(UIBox);
+}
+
+bool UIBox::WantsHoverTick() const
+{
+	return false;
+}
+
+void UIBox::AddBlurBackgroundsInside(int64_t Difference)
+{
+	for (UIBox* i = this; i; i = i->Parent)
+	{
+		i->BlurBackgroundsInside = size_t(int64_t(i->BlurBackgroundsInside) + Difference);
+	}
+}
+
+bool UIBox::LayerContainsBlur() const
+{
+	// A blur background samples the UI texture of the window, which doesn't contain anything drawn into the layer.
+	return BlurBackgroundsInside != 0;
+}
+
+void UIBox::DrawLayer(const UIManager::RedrawBox& Box)
+{
+	const Vec2f WindowSize = Vec2f(ParentWindow->GetSize());
+	const Vec2f Min = (GetPosition() + 1) / 2 * WindowSize;
+	const Vec2f Max = (GetPosition() + Size + 1) / 2 * WindowSize;
+	const Vec2i PixelPosition = Vec2i(int64_t(std::floor(Min.X)), int64_t(std::floor(Min.Y)));
+	const Vec2ui PixelSize = Vec2ui::Max(Vec2ui(
+		uint64_t(std::ceil(Max.X) - float(PixelPosition.X)),
+		uint64_t(std::ceil(Max.Y) - float(PixelPosition.Y))), 1);
+
+	// The layer is drawn again as soon as something inside of it has changed, even if it isn't in the redrawn area,
+	// so the children always reset their Redrawn flag.
+	if (Layer->Dirty)
+	{
+		UIBackground::FlushBatch();
+		Layer->Begin(PixelPosition, PixelSize, ParentWindow->GetSize(),
+			ParentWindow->UI.GetFramebufferFormat() == UIManager::FramebufferFormat::RGBA16F);
+
+		const UIManager::RedrawBox LayerBox = UIManager::RedrawBox{
+			.Min = GetPosition(),
+			.Max = GetPosition() + Size,
+		};
+		Draw();
+		for (auto c : Children)
+		{
+			c->DrawThisAndChildren(LayerBox);
+		}
+		UIBackground::FlushBatch();
+		Layer->End();
+	}
+
+	if (UIManager::RedrawBox::IsBoxOverlapping(Box, UIManager::RedrawBox{
+		.Min = GetPosition(),
+		.Max = GetPosition() + Size
+		}))
+	{
+		UIBackground::FlushBatch();
+		Layer->Draw(ParentWindow->Shaders.LoadShader("res:shaders/uilayer.vert", "res:shaders/uilayer.frag", "UI layer shader"));
+	}
+}
+
 void UIBox::DeleteChildren()
 {
-	while (Children.size() != 0)
+	if (Children.empty())
+	{
+		return;
+	}
+
+	// Detach all children first, so they don't have to remove themselves from this box one by one.
+	std::vector<UIBox*> OldChildren;
+	std::swap(OldChildren, Children);
+
+	// The children don't update the count themselves, since this box is treated as being destroyed.
+	int64_t RemovedBlurBackgrounds = 0;
+	for (UIBox* Child : OldChildren)
+	{
+		RemovedBlurBackgrounds += int64_t(Child->BlurBackgroundsInside);
+	}
+	if (RemovedBlurBackgrounds)
+	{
+		AddBlurBackgroundsInside(-RemovedBlurBackgrounds);
+	}
+
+	bool WasBeingDestroyed = IsBeingDestroyed;
+	IsBeingDestroyed = true;
+	for (UIBox* Child : OldChildren)
 	{
-		delete Children[0];
+		delete Child;
+	}
+	IsBeingDestroyed = WasBeingDestroyed;
+
+	if (!IsBeingDestroyed)
+	{
+		InvalidateLayout();
+		RedrawElement();
 	}
-	Children.clear();
 }
 
-bool UIBox::IsVisibleInHierarchy()
+bool UIBox::IsVisibleInHierarchy() const
 {
-	if (!Parent) return IsVisible;
-	if (IsVisible) return Parent->IsVisibleInHierarchy();
-	return false;
+	return VisibleInHierarchy;
 }
 
 bool UIBox::IsBeingHovered()
@@ -6,8 +6,9 @@ using namespace kui;
 
 void UIButton::Tick()
 {
-	if (!IsVisible)
+	if (!GetVisible())
 	{
+		SetTickEnabled(false);
 		return;
 	}
 
@@ -108,6 +109,16 @@ void UIButton::Tick()
 		break;
 	}
 
+	// Nothing changes until the button is hovered or focused again, which re-enables ticking.
+	if (CurrentButtonState == ButtonState::Normal && !IsHovered && !IsPressed && !IsSelected)
+	{
+		SetTickEnabled(false);
+	}
+}
+
+bool UIButton::WantsHoverTick() const
+{
+	return true;
 }
 
 void UIButton::OnButtonClicked()
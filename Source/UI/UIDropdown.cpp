@@ -33,7 +33,7 @@ UIDropdown::UIDropdown(Vec2f Position,
 
 	OptionsBox = new UIBox(false, Position + Vec2(0, -1));
 	OptionsBox->SetMinSize(SizeVec(Vec2f(0, 1), SizeMode::AspectRelative));
-	OptionsBox->IsVisible = false;
+	OptionsBox->SetVisible(false);
 	GenerateOptions();
 }
 
@@ -102,23 +102,28 @@ void UIDropdown::Tick()
 {
 	UIButton::Tick();
 	if (Window::GetActiveWindow()->Input.IsLMBDown
-		&& OptionsBox->IsVisible
+		&& OptionsBox->GetVisible()
 		&& (!ParentWindow->UI.HoveredBox || !(ParentWindow->UI.HoveredBox == this || ParentWindow->UI.HoveredBox->IsChildOf(OptionsBox))))
 	{
-		OptionsBox->IsVisible = false;
+		OptionsBox->SetVisible(false);
 	}
 	OptionsBox->SetCurrentScrollObject(CurrentScrollObject);
 	OptionsBox->SetPosition(OffsetPosition + Vec2(0, -1));
+	if (OptionsBox->GetVisible())
+	{
+		SetTickEnabled(true);
+	}
 }
 
 void UIDropdown::OnButtonClicked()
 {
-	OptionsBox->IsVisible = !OptionsBox->IsVisible;
+	OptionsBox->SetVisible(!OptionsBox->GetVisible());
+	SetTickEnabled(true);
 }
 
 void UIDropdown::OnChildClicked(int Index)
 {
 	SelectOption((size_t)Index);
-	OptionsBox->IsVisible = false;
+	OptionsBox->SetVisible(false);
 	ParentWindow->UI.KeyboardFocusBox = this;
 }
\ No newline at end of file
@@ -1,8 +1,12 @@
 #include <kui/UI/UIManager.h>
 #include "../Internal/OpenGL.h"
+#include "../Internal/HoverIndex.h"
+#include "../Internal/DamageMap.h"
+#include "../Internal/LayerCache.h"
 #include <kui/Window.h>
 #include <kui/UI/UIBox.h>
 #include <kui/UI/UIBlurBackground.h>
+#include <kui/UI/UIScrollBox.h>
 #include <kui/Image.h>
 #include <kui/Resource.h>
 #include <algorithm>
@@ -15,87 +19,166 @@ UIManager::UIManager()
 {
 	UITextures[0] = 0;
 	UITextures[1] = 0;
+	HoverBoxIndex = new internal::HoverIndex();
+	Damage = new internal::DamageMap();
 }
 
 UIManager::~UIManager()
 {
 	UIBackground::FreeVertexBuffer();
 	ClearUI();
-	GLsizei NumBuffers = UseAlphaBuffer ? 2 : 1;
-	glDeleteFramebuffers(1, &UIBuffer);
-	glDeleteTextures(NumBuffers, UITextures);
+	FreeFramebuffer();
 
 	for (auto& i : ReferencedTextures)
 	{
 		image::UnloadImage(i.first);
 	}
 	ReferencedTextures.clear();
+	delete HoverBoxIndex;
+	delete Damage;
 }
 
-void UIManager::ForceUpdateUI()
+void UIManager::FreeFramebuffer()
 {
-	if (UIBuffer)
+	if (!UIBuffer)
 	{
-		glDeleteFramebuffers(1, &UIBuffer);
-		GLsizei NumBuffers = UseAlphaBuffer ? 2 : 1;
-		glDeleteTextures(NumBuffers, UITextures);
+		return;
 	}
+	GLsizei NumBuffers = UseAlphaBuffer ? 2 : 1;
+	glDeleteFramebuffers(1, &UIBuffer);
+	glDeleteTextures(NumBuffers, UITextures);
 	UIBuffer = 0;
+	UITextures[0] = 0;
+	UITextures[1] = 0;
+	FramebufferSize = 0;
+}
+
+void UIManager::ForceUpdateUI()
+{
 	InitUI();
+	// Sizes relative to the window have changed, so every box has to be measured again.
 	for (UIBox* i : UIElements)
 	{
+		i->MeasureDirty = true;
 		if (!i->GetParent())
 		{
-			i->InvalidateLayout();
+			ElementsToUpdate.insert(i);
 		}
 	}
 }
 
+void UIManager::SetFramebufferFormat(FramebufferFormat NewFormat)
+{
+	if (NewFormat == Format)
+	{
+		return;
+	}
+	Format = NewFormat;
+	if (UIBuffer)
+	{
+		InitUI();
+	}
+}
+
+UIManager::FramebufferFormat UIManager::GetFramebufferFormat() const
+{
+	return Format;
+}
+
+Vec2ui UIManager::GetFramebufferSize() const
+{
+	return FramebufferSize;
+}
+
+Vec2f UIManager::GetFramebufferUVScale() const
+{
+	if (FramebufferSize.X == 0 || FramebufferSize.Y == 0)
+	{
+		return 1;
+	}
+	return Vec2f(Window::GetActiveWindow()->GetSize()) / Vec2f(FramebufferSize);
+}
+
+// The UI textures grow in steps of this many pixels, so resizing a window by dragging it's border only reallocates them occasionally.
+static const uint64_t FramebufferGrowStep = 256;
+
 void UIManager::InitUI()
 {
-	glGenFramebuffers(1, &UIBuffer);
+	const Vec2ui WindowSize = Vec2ui::Max(Window::GetActiveWindow()->GetSize(), 1);
+
+	const Vec2ui RoundedSize = Vec2ui(
+		(WindowSize.X + FramebufferGrowStep - 1) / FramebufferGrowStep * FramebufferGrowStep,
+		(WindowSize.Y + FramebufferGrowStep - 1) / FramebufferGrowStep * FramebufferGrowStep);
+
+	bool Fits = UIBuffer
+		&& AllocatedFormat == Format
+		&& WindowSize.X <= FramebufferSize.X
+		&& WindowSize.Y <= FramebufferSize.Y
+		// Don't keep a texture that is much larger than the window around forever.
+		// Compared per axis with the rounded size, so a texture allocated with the rounded size always fits.
+		&& RoundedSize.X * 2 > FramebufferSize.X
+		&& RoundedSize.Y * 2 > FramebufferSize.Y;
+
+	if (!Fits)
+	{
+		// The first allocation uses the exact window size. Only windows that have been resized get extra space.
+		Vec2ui NewSize = UIBuffer ? RoundedSize : WindowSize;
+		FreeFramebuffer();
+		FramebufferSize = NewSize;
+		AllocatedFormat = Format;
 
-	GLsizei NumBuffers = UseAlphaBuffer ? 2 : 1;
+		glGenFramebuffers(1, &UIBuffer);
 
-	glGenTextures(NumBuffers, UITextures);
-	glBindTexture(GL_TEXTURE_2D, UITextures[0]);
-
-	GLsizei x = (GLsizei)Window::GetActiveWindow()->GetSize().X, y = (GLsizei)Window::GetActiveWindow()->GetSize().Y;
-	glTexImage2D(GL_TEXTURE_2D,
-		0,
-		GL_RGBA16F,
-		x,
-		y,
-		0,
-		GL_RGBA,
-		GL_FLOAT,
-		NULL);
-
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-
-	glBindFramebuffer(GL_FRAMEBUFFER, UIBuffer);
-	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, UITextures[0], 0);
-	
-	if (UseAlphaBuffer)
-	{
-		glBindTexture(GL_TEXTURE_2D, UITextures[1]);
+		GLsizei NumBuffers = UseAlphaBuffer ? 2 : 1;
+
+		glGenTextures(NumBuffers, UITextures);
+		glBindTexture(GL_TEXTURE_2D, UITextures[0]);
+
+		GLsizei x = (GLsizei)FramebufferSize.X, y = (GLsizei)FramebufferSize.Y;
 		glTexImage2D(GL_TEXTURE_2D,
 			0,
-			GL_RGBA8,
+			Format == FramebufferFormat::RGBA16F ? GL_RGBA16F : GL_RGBA8,
 			x,
 			y,
 			0,
 			GL_RGBA,
-			GL_FLOAT,
+			Format == FramebufferFormat::RGBA16F ? GL_FLOAT : GL_UNSIGNED_BYTE,
 			NULL);
 
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, UIBuffer);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, UITextures[0], 0);
 
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, UITextures[1], 0);
+		if (UseAlphaBuffer)
+		{
+			glBindTexture(GL_TEXTURE_2D, UITextures[1]);
+			glTexImage2D(GL_TEXTURE_2D,
+				0,
+				GL_RGBA8,
+				x,
+				y,
+				0,
+				GL_RGBA,
+				GL_UNSIGNED_BYTE,
+				NULL);
+
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, UITextures[1], 0);
+		}
+
+		// The unused part of the texture is never drawn to, but blurring might sample close to it.
+		glDisable(GL_SCISSOR_TEST);
+		glClearColor(0, 0, 0, 0);
+		glClear(GL_COLOR_BUFFER_BIT);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 	}
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	Damage->SetSize(WindowSize);
 	RedrawUI();
 }
 
@@ -106,34 +189,77 @@ unsigned int UIManager::GetUIFramebuffer() const
 
 void UIManager::RedrawUI()
 {
-	RedrawArea(RedrawBox{
-			.Min = -1,
-			.Max = 1,
-		});
+	Damage->AddAll();
+	for (UIBlurBackground* bg : UIBlurBackground::BlurBackgrounds)
+	{
+		if (&bg->ParentWindow->UI == this)
+		{
+			bg->BlurDirty = true;
+		}
+	}
+	for (UIBox* i : LayerBoxes)
+	{
+		i->Layer->Dirty = true;
+	}
 }
 
 void UIManager::ClearUI()
 {
 	ElementsToUpdate.clear();
-	while (UIElements.size())
+	// Deleting a root also deletes all of it's children.
+	while (FirstRoot)
 	{
-		delete UIElements[0];
+		delete FirstRoot;
 	}
-	UIElements.clear();
 	RedrawUI();
 }
 
-bool UIManager::GetShouldRedrawUI() const
+void UIManager::AddRoot(UIBox* Root)
 {
-	return RequiresRedraw;
+	Root->AssignSiblingOrder();
+	Root->PrevRoot = LastRoot;
+	Root->NextRoot = nullptr;
+	if (LastRoot)
+	{
+		LastRoot->NextRoot = Root;
+	}
+	else
+	{
+		FirstRoot = Root;
+	}
+	LastRoot = Root;
+}
+
+void UIManager::RemoveRoot(UIBox* Root)
+{
+	if (Root->PrevRoot)
+	{
+		Root->PrevRoot->NextRoot = Root->NextRoot;
+	}
+	else if (FirstRoot == Root)
+	{
+		FirstRoot = Root->NextRoot;
+	}
+	else
+	{
+		return;
+	}
+
+	if (Root->NextRoot)
+	{
+		Root->NextRoot->PrevRoot = Root->PrevRoot;
+	}
+	else
+	{
+		LastRoot = Root->PrevRoot;
+	}
+	Root->PrevRoot = nullptr;
+	Root->NextRoot = nullptr;
 }
 
-static UIManager::RedrawBox CombineBoxes(const UIManager::RedrawBox& BoxA, const UIManager::RedrawBox& BoxB)
+bool UIManager::GetShouldRedrawUI() const
 {
-	return UIManager::RedrawBox{
-		.Min = Vec2f::Min(BoxA.Min, BoxB.Min),
-		.Max = Vec2f::Max(BoxA.Max, BoxB.Max),
-	};
+	return RequiresRedraw;
 }
 
 bool UIManager::DrawElements()
@@ -142,71 +268,144 @@ bool UIManager::DrawElements()
 
 	if (!ElementsToUpdate.empty())
 	{
-		for (UIBox* Element : ElementsToUpdate)
+		// Elements invalidated while updating the layout will be updated on the next frame.
+		std::set<UIBox*> UpdatedElements;
+		std::swap(UpdatedElements, ElementsToUpdate);
+		for (UIBox* Element : UpdatedElements)
 		{
-			Element->UpdateSelfAndChildren();
+			// An element might have been attached to another box after it was invalidated,
+			// or it might already have been laid out as part of another element that was updated.
+			// In both cases, there is nothing left to do here.
+			if (Element->MeasureDirty && (!Element->Parent || Element->IsLayoutBoundary()))
+			{
+				Element->UpdateSelfAndChildren();
+			}
 		}
-		ElementsToUpdate.clear();
+		InvalidateHoveredBox();
 	}
 
-	if (!RedrawBoxes.empty())
+	Vec2ui WindowSize = Window::GetActiveWindow()->GetSize();
+	if (Damage->GetSize() != WindowSize)
 	{
-		glBindFramebuffer(GL_FRAMEBUFFER, UIBuffer);
-		glClearColor(0, 0, 0, 0);
-		glEnable(GL_SCISSOR_TEST);
-		if (UseAlphaBuffer)
+		RedrawUI();
+	}
+	Damage->SetSize(WindowSize);
+
+	if (!Damage->IsEmpty())
+	{
+		// A blur background whose cached blur is out of date samples everything behind it again,
+		// so that area has to be redrawn completely.
+		// Repeated, since the new blurred image can be behind another blur background.
+		for (UIBlurBackground* bg : UIBlurBackground::BlurBackgrounds)
 		{
-			unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
-			glDrawBuffers(2, attachments);
+			// Moving a background changes what is behind it, even if nothing else has changed.
+			RedrawBox BackgroundBox = bg->GetRedrawBox();
+			if (BackgroundBox.Min != bg->BlurredBox.Min || BackgroundBox.Max != bg->BlurredBox.Max)
+			{
+				bg->BlurDirty = true;
+			}
 		}
-		Vec2ui WindowSize = Window::GetActiveWindow()->GetSize();
-
-		glViewport(0, 0, (GLint)WindowSize.X, (GLint)WindowSize.Y);
-		for (auto& i : RedrawBoxes)
+		std::vector<UIBlurBackground*> ExpandedBackgrounds;
+		bool AddedBackground = true;
+		while (AddedBackground)
 		{
+			AddedBackground = false;
 			for (UIBlurBackground* bg : UIBlurBackground::BlurBackgrounds)
 			{
-				RedrawBox BackgroundBox = bg->GetRedrawBox();
+				if (!bg->BlurDirty || &bg->ParentWindow->UI != this || !bg->IsVisibleInHierarchy()
+					|| std::find(ExpandedBackgrounds.begin(), ExpandedBackgrounds.end(), bg) != ExpandedBackgrounds.end())
+				{
+					continue;
+				}
+				ExpandedBackgrounds.push_back(bg);
+				AddedBackground = true;
 
-				if (RedrawBox::IsBoxOverlapping(i, BackgroundBox))
+				RedrawBox BackgroundBox = bg->GetRedrawBox();
+				for (UIBlurBackground* Other : UIBlurBackground::BlurBackgrounds)
 				{
-					i = CombineBoxes(i, BackgroundBox);
+					if (Other != bg && &Other->ParentWindow->UI == this && RedrawBox::IsBoxOverlapping(BackgroundBox, Other->GetRedrawBox()))
+					{
+						Other->BlurDirty = true;
+					}
 				}
 			}
+		}
 
-			i.Max += Vec2f(3) / Vec2f(WindowSize);
-			i.Min = i.Min - Vec2f(3) / Vec2f(WindowSize);
-
-			i.Min = i.Min.Clamp(-1, 1);
-			i.Max = i.Max.Clamp(-1, 1);
-
-			Vec2f Pos = (i.Min / 2 + 0.5f) * Vec2f(WindowSize);
-			Vec2f Res = (i.Max - i.Min) / 2 * Vec2f(WindowSize);
+		// The area of a blur background has to be drawn in a single pass, before anything else. If it was split into
+		// multiple rectangles, it would blur the parts of the previous frame that haven't been drawn again yet.
+		// Overlapping backgrounds share a pass, so the one in front blurs the new image of the one behind it.
+		std::vector<internal::DamageMap::Rect> DamagedRects;
+		for (UIBlurBackground* bg : ExpandedBackgrounds)
+		{
+			RedrawBox BackgroundBox = bg->GetRedrawBox();
+			internal::DamageMap::Rect BackgroundRect;
+			if (!Damage->GetTileRect(BackgroundBox.Min, BackgroundBox.Max, 3, BackgroundRect))
+			{
+				continue;
+			}
+			for (size_t i = 0; i < DamagedRects.size();)
+			{
+				const internal::DamageMap::Rect& Other = DamagedRects[i];
+				if (Other.X < BackgroundRect.X + BackgroundRect.Width && BackgroundRect.X < Other.X + Other.Width
+					&& Other.Y < BackgroundRect.Y + BackgroundRect.Height && BackgroundRect.Y < Other.Y + Other.Height)
+				{
+					uint32_t MaxX = std::max(Other.X + Other.Width, BackgroundRect.X + BackgroundRect.Width);
+					uint32_t MaxY = std::max(Other.Y + Other.Height, BackgroundRect.Y + BackgroundRect.Height);
+					BackgroundRect.X = std::min(Other.X, BackgroundRect.X);
+					BackgroundRect.Y = std::min(Other.Y, BackgroundRect.Y);
+					BackgroundRect.Width = MaxX - BackgroundRect.X;
+					BackgroundRect.Height = MaxY - BackgroundRect.Y;
+					// The merged rectangle might overlap rectangles that have already been checked.
+					DamagedRects.erase(DamagedRects.begin() + i);
+					i = 0;
+					continue;
+				}
+				i++;
+			}
+			DamagedRects.push_back(BackgroundRect);
+		}
+		for (const internal::DamageMap::Rect& Rect : DamagedRects)
+		{
+			Damage->Remove(Rect);
+		}
+		std::vector<internal::DamageMap::Rect> RemainingRects;
+		Damage->GetRects(RemainingRects);
+		DamagedRects.insert(DamagedRects.end(), RemainingRects.begin(), RemainingRects.end());
 
-			ScissorXY = Vec2ui(uint64_t(Pos.X), uint64_t(Pos.Y));
-			ScissorWH = Vec2ui(
-				std::clamp((GLsizei)Res.X + 1, 0, (GLsizei)WindowSize.X),
-				std::clamp((GLsizei)Res.Y + 1, 0, (GLsizei)WindowSize.Y)
-			);
+		glBindFramebuffer(GL_FRAMEBUFFER, UIBuffer);
+		glClearColor(0, 0, 0, 0);
+		glEnable(GL_SCISSOR_TEST);
+		if (UseAlphaBuffer)
+		{
+			unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+			glDrawBuffers(2, attachments);
+		}
+		glViewport(0, 0, (GLint)WindowSize.X, (GLint)WindowSize.Y);
+		LastDamagedPixels = 0;
+		for (const internal::DamageMap::Rect& Rect : DamagedRects)
+		{
+			glScissor(GLint(Rect.X), GLint(Rect.Y), GLsizei(Rect.Width), GLsizei(Rect.Height));
+			LastDamagedPixels += size_t(Rect.Width) * size_t(Rect.Height);
 
-			glScissor(
-				GLint(ScissorXY.X),
-				GLint(ScissorXY.Y),
-				GLsizei(ScissorWH.X),
-				GLsizei(ScissorWH.Y)
-			);
+			// Elements outside of the rectangle are skipped.
+			RedrawBox Box = RedrawBox{
+				.Min = Vec2f(float(Rect.X), float(Rect.Y)) / Vec2f(WindowSize) * 2 - 1,
+				.Max = Vec2f(float(Rect.X + Rect.Width), float(Rect.Y + Rect.Height)) / Vec2f(WindowSize) * 2 - 1,
+			};
 
 			glClear(GL_COLOR_BUFFER_BIT);
-			for (UIBox* elem : UIElements)
+			for (UIBox* elem = FirstRoot; elem; elem = elem->NextRoot)
 			{
-				if (elem->Parent == nullptr)
-					elem->DrawThisAndChildren(i);
+				elem->DrawThisAndChildren(Box);
 			}
+			UIBackground::FlushBatch();
 		}
+		LastDamagedRects = DamagedRects.size();
+		Damage->AddDrawnFrame(DamagedRects);
 		glDisable(GL_SCISSOR_TEST);
 		glScissor(0, 0, (GLsizei)Window::GetActiveWindow()->GetSize().X, (GLsizei)Window::GetActiveWindow()->GetSize().Y);
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
-		RedrawBoxes.clear();
+		Damage->Clear();
 		return true;
 	}
 	return false;
@@ -214,29 +413,62 @@ bool UIManager::DrawElements()
 
 void kui::UIManager::TickElements()
 {
-	NewHoveredBox = nullptr;
-	for (size_t i = 0; i < UIElements.size(); i++)
+	UIBox* OldHoveredBox = HoveredBox;
+	UpdateHoveredBox();
+
+	// Interactive elements only need to tick while they are hovered or focused.
+	// They remove themselves from the tick list once they are idle again.
+	if (HoveredBox && HoveredBox->WantsHoverTick())
+	{
+		HoveredBox->SetTickEnabled(true);
+	}
+	if (HoveredBox && HoveredBox != OldHoveredBox)
 	{
-		UIBox* elem = UIElements[i];
-		if (elem->IsVisible != elem->PrevIsVisible)
+		// Scroll boxes can be scrolled while any of their children is hovered.
+		for (UIBox* i = HoveredBox->Parent; i; i = i->Parent)
 		{
-			elem->RedrawElement(true);
-			if (!elem->IsVisible && Window::GetActiveWindow()->UI.KeyboardFocusBox == elem)
+			if (dynamic_cast<UIScrollBox*>(i))
 			{
-				Window::GetActiveWindow()->UI.KeyboardFocusBox = nullptr;
+				i->SetTickEnabled(true);
 			}
-			elem->PrevIsVisible = elem->IsVisible;
 		}
-		if (elem->ShouldBeTicked)
+	}
+	if (KeyboardFocusBox && KeyboardFocusBox->WantsHoverTick())
+	{
+		KeyboardFocusBox->SetTickEnabled(true);
+	}
+
+	// Iterate backwards, so elements can remove themselves from the list while being ticked.
+	for (size_t i = TickedElements.size(); i > 0; i--)
+	{
+		if (i > TickedElements.size())
 		{
-			elem->Tick();
+			continue;
 		}
-		if (!elem->Parent)
+		UIBox* elem = TickedElements[i - 1];
+		if (elem->ShouldBeTicked)
 		{
-			elem->UpdateHoveredState();
+			elem->Tick();
 		}
 	}
-	HoveredBox = NewHoveredBox;
+}
+
+void UIManager::UpdateHoveredBox()
+{
+	Vec2f MousePosition = Window::GetActiveWindow()->Input.MousePosition;
+	if (!HoveredBoxDirty && MousePosition == LastHoverPosition)
+	{
+		return;
+	}
+
+	HoveredBox = HoverBoxIndex->FindHoveredBox(MousePosition);
+	LastHoverPosition = MousePosition;
+	HoveredBoxDirty = false;
+}
+
+void UIManager::InvalidateHoveredBox()
+{
+	HoveredBoxDirty = true;
 }
 
 void UIManager::UpdateEvents()
@@ -400,8 +632,6 @@ UIBox* kui::UIManager::GetNextFocusableBox(UIBox* From, bool Reverse)
 
 		auto Iterate = [this, &From, &WithParent, &Found, Reverse](UIBox* Box) -> UIBox*
 			{
-				if (Box->Parent)
-					return nullptr;
 				if (!WithParent && From && (From->IsChildOf(Box) || From == Box))
 				{
 					Found = true;
@@ -421,16 +651,16 @@ UIBox* kui::UIManager::GetNextFocusableBox(UIBox* From, bool Reverse)
 
 		if (Reverse)
 		{
-			for (int64_t i = UIElements.size() - 1; i >= 0; i--)
+			for (UIBox* Box = LastRoot; Box; Box = Box->PrevRoot)
 			{
-				UIBox* ElementResult = Iterate(UIElements[i]);
+				UIBox* ElementResult = Iterate(Box);
 				if (ElementResult)
 					return ElementResult;
 			}
 		}
 		else
 		{
-			for (UIBox* Box : UIElements)
+			for (UIBox* Box = FirstRoot; Box; Box = Box->NextRoot)
 			{
 				UIBox* ElementResult = Iterate(Box);
 				if (ElementResult)
@@ -441,7 +671,7 @@ UIBox* kui::UIManager::GetNextFocusableBox(UIBox* From, bool Reverse)
 	return nullptr;
 }
 
-void UIManager::RedrawArea(RedrawBox Box)
+void UIManager::RedrawArea(RedrawBox Box, UIBox* Source)
 {
 	// Do not redraw the element if it's position has not yet been initialized.
 	// It will be redrawn once the position has been set anyways.
@@ -451,37 +681,61 @@ void UIManager::RedrawArea(RedrawBox Box)
 		return;
 	}
 
-	RedrawBox* CurrentBox = &Box;
-	size_t CurrentBoxIndex = SIZE_MAX;
+	// Some pixels around the box are included, for anti aliasing and borders drawn slightly outside of it.
+	Damage->Add(Box.Min, Box.Max, 3);
 
-	if (RedrawBoxes.size() > 8)
+	// Blur backgrounds only have to be blurred again if something behind them has changed.
+	// Their own children are drawn on top of the blurred image.
+	for (UIBlurBackground* bg : UIBlurBackground::BlurBackgrounds)
 	{
-		RedrawBoxes.clear();
-		RedrawUI();
+		if (bg->BlurDirty || &bg->ParentWindow->UI != this
+			|| (Source && (Source == bg || Source->IsChildOf(bg))))
+		{
+			continue;
+		}
+		RedrawBox BackgroundBox = bg->GetRedrawBox();
+		if (RedrawBox::IsBoxOverlapping(Box, BackgroundBox))
+		{
+			bg->BlurDirty = true;
+		}
 	}
 
-	for (size_t i = 0; i < RedrawBoxes.size(); i++)
+	// Cached layers only contain their own box and it's children, so they only have to be drawn again if one of those changed.
+	if (Source)
 	{
-		RedrawBox& IteratedBox = RedrawBoxes[i];
-
-		if (IteratedBox.Min == Box.Min && IteratedBox.Max == Box.Max)
+		for (UIBox* i = Source; i; i = i->Parent)
 		{
-			return;
+			if (i->Layer)
+			{
+				i->Layer->Dirty = true;
+			}
 		}
-
-		if (RedrawBox::IsBoxOverlapping(*CurrentBox, IteratedBox))
+	}
+	else
+	{
+		for (UIBox* i : LayerBoxes)
 		{
-			// If 2 overlapping redraw areas are given, we combine them to avoid redrawing the same area twice.
-			IteratedBox = CombineBoxes(*CurrentBox, IteratedBox);
-			CurrentBox = &IteratedBox;
-			CurrentBoxIndex = i;
+			if (RedrawBox::IsBoxOverlapping(Box, i->GetRedrawBox()))
+			{
+				i->Layer->Dirty = true;
+			}
 		}
 	}
+}
 
-	if (CurrentBoxIndex == SIZE_MAX)
-	{
-		RedrawBoxes.push_back(Box);
-	}
+size_t UIManager::GetDamagedPixelArea() const
+{
+	return LastDamagedPixels;
+}
+
+size_t UIManager::GetDamagedRectCount() const
+{
+	return LastDamagedRects;
+}
+
+const internal::DamageMap* UIManager::GetDamageMap() const
+{
+	return Damage;
 }
 
 bool UIManager::RedrawBox::IsBoxOverlapping(const UIManager::RedrawBox& BoxA, const UIManager::RedrawBox& BoxB)
@@ -12,6 +12,11 @@ bool UIScrollBox::IsDraggingScrollBox = false;
 
 float UIScrollBox::GetDesiredChildrenSize()
 {
+	if (Virtualized)
+	{
+		return float(VirtualItemCount) * VirtualItemHeight.GetScreen(ParentWindow).Y;
+	}
+
 	float DesiredSize = 0;
 	for (UIBox* i : Children)
 	{
@@ -27,7 +32,11 @@ void UIScrollBox::UpdateScrollObjectOfObject(UIBox* o)
 {
 	if (o != this)
 	{
-		o->CurrentScrollObject = &ScrollClass;
+		if (o->CurrentScrollObject != &ScrollClass)
+		{
+			o->CurrentScrollObject = &ScrollClass;
+			o->UpdateHoverEntry();
+		}
 		if (dynamic_cast<UIScrollBox*>(o) && o != this)
 		{
 			return;
@@ -76,6 +85,7 @@ UIScrollBox* UIScrollBox::SetDisplayScrollBar(bool NewDisplay)
 			ScrollBarBackground = nullptr;
 			ScrollBar = nullptr;
 		}
+		SetTickEnabled(true);
 	}
 	return this;
 }
@@ -100,7 +110,7 @@ void UIScrollBox::Tick()
 	}
 	if (ScrollBarBackground)
 	{
-		ScrollBarBackground->IsVisible = VisibleInHierarchy && DesiredMaxScroll > Size.Y;
+		ScrollBarBackground->SetVisible(VisibleInHierarchy && DesiredMaxScroll > Size.Y);
 	}
 	if (ScrollBar && VisibleInHierarchy)
 	{
@@ -164,14 +174,169 @@ void UIScrollBox::Tick()
 		IsDragging = false;
 	}
 
+	UpdateVirtualItems(false);
+
 	if (OldPercentage != ScrollClass.Scrolled)
 	{
 		OldPercentage = ScrollClass.Scrolled;
+		ParentWindow->UI.InvalidateHoveredBox();
 		if (OnScroll)
 		{
 			OnScroll(this);
 		}
 	}
+
+	// Scrolling needs the box to be hovered or its scroll bar to be dragged, so nothing changes until then.
+	// Update() enables ticking again when the layout changes, and UIManager::TickElements()
+	// when the box or one of its children is hovered.
+	if (!ScrollClass.Active && !IsDragging)
+	{
+		SetTickEnabled(false);
+	}
+}
+
+UIScrollBox* UIScrollBox::SetVirtualItems(size_t ItemCount, UISize ItemHeight,
+	std::function<UIBox*()> CreateItem,
+	std::function<void(UIBox* Item, size_t Index)> UpdateItem)
+{
+	DeleteChildren();
+	VirtualItems.clear();
+	FirstVirtualItem = 0;
+
+	Virtualized = true;
+	VirtualItemCount = ItemCount;
+	VirtualItemHeight = ItemHeight;
+	CreateVirtualItem = CreateItem;
+	UpdateVirtualItem = UpdateItem;
+
+	// The spacers take up the space of all items above and below the visible ones.
+	VirtualTopSpacer = new UIBox(true, 0);
+	VirtualBottomSpacer = new UIBox(true, 0);
+	AddChild(VirtualTopSpacer);
+	AddChild(VirtualBottomSpacer);
+
+	UpdateVirtualItems(true);
+	return this;
+}
+
+UIScrollBox* UIScrollBox::SetVirtualItemCount(size_t NewItemCount)
+{
+	VirtualItemCount = NewItemCount;
+	UpdateVirtualItems(true);
+	return this;
+}
+
+size_t UIScrollBox::GetVirtualItemCount() const
+{
+	return VirtualItemCount;
+}
+
+void UIScrollBox::DeleteChildren()
+{
+	// The items and spacers are children of this box, so they are deleted too.
+	Virtualized = false;
+	VirtualItems.clear();
+	VirtualItemCount = 0;
+	FirstVirtualItem = 0;
+	VirtualTopSpacer = nullptr;
+	VirtualBottomSpacer = nullptr;
+	CreateVirtualItem = nullptr;
+	UpdateVirtualItem = nullptr;
+	UIBox::DeleteChildren();
+}
+
+void UIScrollBox::UpdateVirtualItems(bool UpdateAll)
+{
+	if (!Virtualized)
+	{
+		return;
+	}
+	if (Children.size() != VirtualItems.size() + 2)
+	{
+		// The pointers to the items and spacers might not be valid anymore.
+		app::error::Error("Added or deleted a child of a virtualized UIScrollBox", true);
+		return;
+	}
+
+	float ItemHeight = VirtualItemHeight.GetScreen(ParentWindow).Y;
+	if (ItemHeight <= 0)
+	{
+		return;
+	}
+
+	size_t First = size_t(std::max(ScrollClass.Scrolled / ItemHeight, 0.0f));
+	First = std::min(First > VirtualOverscan ? First - VirtualOverscan : 0, VirtualItemCount);
+	size_t VisibleCount = size_t(std::ceil(std::max(Size.Y, 0.0f) / ItemHeight)) + 1 + VirtualOverscan * 2;
+	size_t Count = std::min(VisibleCount, VirtualItemCount - First);
+
+	if (!UpdateAll
+		&& First == FirstVirtualItem
+		&& Count == VirtualItems.size()
+		&& ItemHeight == VirtualItemScreenHeight)
+	{
+		return;
+	}
+
+	// Keep the boxes of items that are still visible, and reuse the others for the new items.
+	std::vector<UIBox*> NewItems = std::vector<UIBox*>(Count, nullptr);
+	std::vector<UIBox*> FreeItems;
+	for (size_t i = 0; i < VirtualItems.size(); i++)
+	{
+		size_t Index = FirstVirtualItem + i;
+		if (!UpdateAll && Index >= First && Index < First + Count)
+		{
+			NewItems[Index - First] = VirtualItems[i];
+		}
+		else
+		{
+			FreeItems.push_back(VirtualItems[i]);
+		}
+	}
+
+	for (size_t i = 0; i < Count; i++)
+	{
+		if (NewItems[i])
+		{
+			continue;
+		}
+		UIBox* Item = nullptr;
+		if (FreeItems.empty())
+		{
+			Item = CreateVirtualItem();
+			AddChild(Item);
+			UpdateScrollObjectOfObject(Item);
+		}
+		else
+		{
+			Item = FreeItems.back();
+			FreeItems.pop_back();
+		}
+		UpdateVirtualItem(Item, First + i);
+		NewItems[i] = Item;
+	}
+
+	for (UIBox* Unused : FreeItems)
+	{
+		delete Unused;
+	}
+
+	Children.clear();
+	Children.push_back(VirtualTopSpacer);
+	Children.insert(Children.end(), NewItems.begin(), NewItems.end());
+	Children.push_back(VirtualBottomSpacer);
+	for (UIBox* Child : Children)
+	{
+		Child->AssignSiblingOrder();
+	}
+
+	VirtualTopSpacer->SetMinSize(SizeVec(Vec2f(0, float(First) * ItemHeight), SizeMode::ScreenRelative));
+	VirtualBottomSpacer->SetMinSize(SizeVec(Vec2f(0, float(VirtualItemCount - First - Count) * ItemHeight), SizeMode::ScreenRelative));
+
+	VirtualItems = NewItems;
+	FirstVirtualItem = First;
+	VirtualItemScreenHeight = ItemHeight;
+	InvalidateLayout();
+	RedrawElement();
 }
 
 void UIScrollBox::SetMaxScroll(float NewMaxScroll)
@@ -185,6 +350,16 @@ float UIScrollBox::GetMaxScroll() const
 	return MaxScroll;
 }
 
+bool UIScrollBox::IsBatchedDraw() const
+{
+	return true;
+}
+
+bool UIScrollBox::WantsHoverTick() const
+{
+	return true;
+}
+
 UIScrollBox* UIScrollBox::SetScrollSpeed(float NewScrollSpeed)
 {
 	ScrollClass.Speed = NewScrollSpeed;
@@ -211,15 +386,15 @@ void UIScrollBox::Update()
 	ScrollClass.Scrolled = Progress;
 	ScrollClass.Speed = Speed;
 	UpdateScrollObjectOfObject(this);
+	// The scroll bar is positioned in Tick().
+	SetTickEnabled(true);
 }
 
 void UIScrollBox::UpdateTickState()
 {
-	for (auto c : Children)
-	{
-		c->UpdateTickState();
-	}
 	ShouldBeTicked = true;
+	// The scroll bar is shown or hidden in Tick().
+	SetTickEnabled(true);
 }
 
 
@@ -227,6 +402,7 @@ UIScrollBox::UIScrollBox(bool Horizontal, Vec2f Position, bool DisplayScrollBar)
 {
 	HasMouseCollision = true;
 	SetDisplayScrollBar(DisplayScrollBar);
+	SetTickEnabled(true);
 	Update();
 }
 
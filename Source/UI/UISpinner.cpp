@@ -11,6 +11,7 @@ UISpinner::UISpinner(Vec2f Position, Vec3f Color, SizeVec Size)
 	))
 {
 	SetMaxSize(Size);
+	SetTickEnabled(Active);
 }
 
 UISpinner::~UISpinner()
@@ -33,13 +34,26 @@ UISpinner* UISpinner::SetBackgroundColor(Vec3f NewColor)
 	return this;
 }
 
-void UISpinner::Tick()
+UISpinner* UISpinner::SetActive(bool NewActive)
 {
-	if (Active)
+	if (NewActive != Active)
 	{
-		Time += ParentWindow->GetDeltaTime() * Speed;
+		Active = NewActive;
+		SetTickEnabled(Active);
 		RedrawElement();
 	}
+	return this;
+}
+
+bool UISpinner::GetActive() const
+{
+	return Active;
+}
+
+void UISpinner::Tick()
+{
+	Time += ParentWindow->GetDeltaTime() * Speed;
+	RedrawElement();
 }
 
 void UISpinner::Draw()
@@ -11,25 +11,46 @@ float UIText::GetRenderedSize() const
 	return TextSize.GetScreen().Y * 100;
 }
 
-float UIText::GetWrapDistance() const
+float UIText::GetScreenWrapDistance() const
 {
 	float Distance = WrapDistance.GetScreen().X;
 	return Distance;
 }
 
+const TextLayout& UIText::GetLayout() const
+{
+	Layout.Update(Renderer, RenderedText, GetRenderedSize(), Wrap, GetScreenWrapDistance(), MaxLines);
+	return Layout;
+}
+
 UIText* UIText::SetFont(Font* NewFont)
 {
 	if (NewFont != Renderer)
 	{
 		Renderer = NewFont;
 		InvalidateLayout();
+		SetTickEnabled(true);
 	}
 	return this;
 }
 
 void UIText::Tick()
 {
+	if (Renderer && !Renderer->IsLoaded())
+	{
+		// Keep ticking until the font has been loaded in the background.
+		WaitingForFont = true;
+		return;
+	}
+	if (WaitingForFont)
+	{
+		WaitingForFont = false;
+		InvalidateLayout();
+		RedrawElement();
+	}
 	SetMinSize(GetUsedSize());
+	// The used size only changes if a property of the text changes, which enables ticking again.
+	SetTickEnabled(false);
 }
 
 Vec3f UIText::GetColor() const
@@ -46,7 +67,8 @@ UIText* UIText::SetColor(Vec3f NewColor)
 		{
 			i.Color = Color;
 		}
-		Update();
+		// Only the vertices of the text have to be generated again, the size and line breaks stay the same.
+		Layout.SetColor(Color);
 		RedrawElement();
 	}
 	return this;
@@ -68,6 +90,7 @@ UIText* UIText::SetTextSize(UISize Size)
 	{
 		TextSize = Size;
 		InvalidateLayout();
+		SetTickEnabled(true);
 	}
 	return this;
 }
@@ -93,6 +116,7 @@ UIText* UIText::SetTextWidthOverride(float NewTextWidthOverride)
 	{
 		TextWidthOverride = NewTextWidthOverride;
 		InvalidateLayout();
+		SetTickEnabled(true);
 	}
 	return this;
 }
@@ -104,19 +128,45 @@ void UIText::SetText(std::string NewText)
 
 UIText* UIText::SetText(std::vector<TextSegment> NewText)
 {
-	if (NewText != RenderedText)
+	if (NewText.size() == 1 && RenderedText.size() == 1
+		&& NewText[0].Color == RenderedText[0].Color
+		&& NewText[0].Text.size() > RenderedText[0].Text.size()
+		&& NewText[0].Text.compare(0, RenderedText[0].Text.size(), RenderedText[0].Text) == 0)
+	{
+		// Text has been appended, so only the last lines have to be laid out and generated again.
+		size_t OldLength = RenderedText[0].Text.size();
+		EditText(OldLength, 0, NewText[0].Text.substr(OldLength));
+	}
+	else if (NewText != RenderedText)
 	{
 		RenderedText = NewText;
-		TextChanged = true;
+		Layout.Invalidate();
 		InvalidateLayout();
+		SetTickEnabled(true);
 		RedrawElement();
 	}
 	return this;
 }
 
+void UIText::EditText(size_t Start, size_t RemovedLength, const std::string& Inserted)
+{
+	if (RenderedText.size() != 1)
+	{
+		std::string NewText = GetText();
+		NewText.replace(Start, RemovedLength, Inserted);
+		SetText(NewText);
+		return;
+	}
+	RenderedText[0].Text.replace(Start, RemovedLength, Inserted);
+	Layout.Edit(RenderedText, Start, RemovedLength, Inserted.size());
+	InvalidateLayout();
+	SetTickEnabled(true);
+	RedrawElement();
+}
+
 size_t UIText::GetNearestLetterAtLocation(Vec2f Location) const
 {
-	if (Renderer == nullptr)
+	if (Renderer == nullptr || !Renderer->IsLoaded())
 		return 0;
 	
 	if (CurrentScrollObject)
@@ -124,9 +174,7 @@ size_t UIText::GetNearestLetterAtLocation(Vec2f Location) const
 		Location.Y -= CurrentScrollObject->GetOffset();
 	}
 
-	size_t Char = Renderer->GetCharacterAtPosition(RenderedText, Location - OffsetPosition - Vec2f(0, Size.Y),
-		GetRenderedSize(), Wrap, GetWrapDistance(), MaxLines);
-	return Char;
+	return GetLayout().GetCharacterAtPosition(Location - OffsetPosition - Vec2f(0, Size.Y));
 }
 
 std::string UIText::GetText() const
@@ -140,7 +188,7 @@ UIText::UIText(UISize Scale, Vec3f Color, std::string Text, Font* NewFont) : UIB
 	this->Color = Color;
 	this->Renderer = NewFont;
 	RenderedText = { TextSegment(Text, Color) };
-	TextChanged = true;
+	SetTickEnabled(true);
 }
 
 UIText::UIText(UISize Scale, std::vector<TextSegment> Text, Font* NewFont) : UIBox(true, 0)
@@ -148,7 +196,7 @@ UIText::UIText(UISize Scale, std::vector<TextSegment> Text, Font* NewFont) : UIB
 	this->TextSize = Scale;
 	this->Renderer = NewFont;
 	RenderedText = Text;
-	TextChanged = true;
+	SetTickEnabled(true);
 }
 
 UIText::~UIText()
@@ -159,10 +207,8 @@ UIText::~UIText()
 
 Vec2f UIText::GetLetterLocation(size_t Index) const
 {
-	if (!Renderer) return 0;
-	Vec2f EndLocation;
-
-	Renderer->GetTextSize(RenderedText, GetRenderedSize(), Wrap, GetWrapDistance(), MaxLines, &EndLocation, Index);
+	if (!Renderer || !Renderer->IsLoaded()) return 0;
+	Vec2f EndLocation = GetLayout().GetLetterLocation(Index);
 	EndLocation.Y = Size.Y - EndLocation.Y;
 	return EndLocation + OffsetPosition;
 }
@@ -171,25 +217,52 @@ UIText* kui::UIText::SetMaxWraps(uint32_t NewMaxLines)
 {
 	if (NewMaxLines != MaxLines)
 	{
-		TextChanged = true;
 		MaxLines = NewMaxLines;
+		InvalidateLayout();
+		SetTickEnabled(true);
 	}
 	return this;
 }
 
 UIText* UIText::SetWrapEnabled(bool WrapEnabled, UISize WrapDistance)
 {
-	this->Wrap = WrapEnabled;
-	this->WrapDistance = WrapDistance;
+	if (WrapEnabled != Wrap || WrapDistance != this->WrapDistance)
+	{
+		this->Wrap = WrapEnabled;
+		this->WrapDistance = WrapDistance;
+		InvalidateLayout();
+		SetTickEnabled(true);
+	}
 	return this;
 }
 
+bool UIText::GetWrapEnabled() const
+{
+	return Wrap;
+}
+
+UISize UIText::GetWrapDistance() const
+{
+	return WrapDistance;
+}
+
+bool UIText::IsBatchedDraw() const
+{
+	return false;
+}
+
 void UIText::Draw()
 {
-	if (!Renderer)
+	if (!Renderer || !Renderer->IsLoaded())
 		return;
+	if (Text && (GetLayout().GetVersion() != DrawnLayoutVersion || Renderer != DrawnFont))
+	{
+		Update();
+	}
 	if (Text)
 	{
+		// Only the lines inside of the clip rect are generated, and glyphs replaced in the font atlas are regenerated.
+		Renderer->UpdateVisibleText(Text, GetLayout(), CurrentScrollObject);
 		Text->Opacity = Opacity;
 		Text->Draw(CurrentScrollObject);
 	}
@@ -197,24 +270,36 @@ void UIText::Draw()
 
 void UIText::Update()
 {
-	if (!Renderer)
+	// The wrap distance might depend on the layout, so the used size has to be checked again.
+	SetTickEnabled(true);
+	if (!Renderer || !Renderer->IsLoaded())
 	{
 		return;
 	}
-	if (Text)
+	const TextLayout& CurrentLayout = GetLayout();
+	Vec2f TextPosition = OffsetPosition + Vec2f(0, Size.Y - GetRenderedSize() / 600 * Renderer->CharacterSize);
+
+	if (Text
+		&& CurrentLayout.GetVersion() == DrawnLayoutVersion
+		&& Renderer == DrawnFont)
 	{
-		delete Text;
+		// Only the position has changed, the vertices can stay the same.
+		Text->SetPosition(TextPosition);
+		return;
 	}
-	if (Wrap)
+
+	if (Text && Renderer == DrawnFont)
 	{
-		Text = Renderer->MakeText(RenderedText, OffsetPosition + Vec2f(0, Size.Y - GetRenderedSize() / 600 * Renderer->CharacterSize),
-			GetRenderedSize(), Color, Opacity, GetWrapDistance(), MaxLines);
+		Renderer->UpdateText(Text, CurrentLayout, TextPosition, Color, Opacity);
 	}
 	else
 	{
-		Text = Renderer->MakeText(RenderedText, OffsetPosition + Vec2f(0, Size.Y - GetRenderedSize() / 600 * Renderer->CharacterSize),
-			GetRenderedSize(), Color, Opacity, 999, MaxLines);
+		delete Text;
+		Text = Renderer->MakeText(CurrentLayout, TextPosition, Color, Opacity);
 	}
+
+	DrawnLayoutVersion = CurrentLayout.GetVersion();
+	DrawnFont = Renderer;
 }
 
 void UIText::OnAttached()
@@ -223,32 +308,10 @@ void UIText::OnAttached()
 
 SizeVec UIText::GetUsedSize()
 {
-	if (!Renderer)
+	if (!Renderer || !Renderer->IsLoaded())
 		return SizeVec(0, SizeMode::ScreenRelative);
 
-	float RenderSize = GetRenderedSize();
-	float WrapDistance = GetWrapDistance();
-
-	Vec2f Size;
-
-	if (RenderSize == LastRenderSize
-		&& LastWrapEnabled == Wrap
-		&& LastWrapDistance == WrapDistance
-		&& ParentWindow->GetAspectRatio() == LastAspect
-		&& !TextChanged)
-	{
-		Size = LastSize;
-	}
-	else
-	{
-		Size = Renderer->GetTextSize(RenderedText, RenderSize, Wrap, WrapDistance, MaxLines);
-		LastSize = Size;
-		LastRenderSize = RenderSize;
-		LastWrapEnabled = Wrap;
-		LastWrapDistance = WrapDistance;
-		LastAspect = ParentWindow->GetAspectRatio();
-		TextChanged = false;
-	}
+	Vec2f Size = GetLayout().GetSize();
 
 	if (TextWidthOverride != 0)
 	{
@@ -16,12 +16,18 @@ void UITextField::Tick()
 {
 	if (Size.X > 0)
 	{
-		TextObject->WrapDistance = UISize::Screen(Size.X - 0.01f);
-		TextObject->Wrap = true;
+		TextObject->SetWrapEnabled(true, UISize::Screen(Size.X - 0.01f));
 	}
 	else
 	{
-		TextObject->Wrap = false;
+		TextObject->SetWrapEnabled(false, TextObject->GetWrapDistance());
+	}
+
+	Font* TextFont = TextObject->GetTextFont();
+	if (TextFont && !TextFont->IsLoaded())
+	{
+		// Measuring the text would wait for the font, so keep ticking until it has been loaded in the background.
+		return;
 	}
 
 	float CharSize = UIText::GetTextSizeAtScale(TextObject->GetTextSize(), TextObject->GetTextFont()).Y;
@@ -29,10 +35,8 @@ void UITextField::Tick()
 		TextScroll.MaxScroll = std::max(TextObject->GetUsedSize().GetScreen().Y - Size.Y + 0.025f, 0.0f);
 	else
 		TextScroll.MaxScroll = 0;
-	TextObject->CurrentScrollObject = &this->TextScroll;
+	TextObject->SetCurrentScrollObject(&this->TextScroll);
 	TextScroll.Parent = CurrentScrollObject;
-	if (CurrentScrollObject)
-		TextObject->IsVisible = false;
 
 	Vec2f Offset;
 	if (CurrentScrollObject != nullptr)
@@ -46,17 +50,18 @@ void UITextField::Tick()
 			ClickStartedOnField = true;
 		}
 
-		size_t Nearest = TextObject->GetNearestLetterAtLocation(ParentWindow->Input.MousePosition);
 		if (!IsHovered)
 		{
 			RedrawElement();
 		}
 		IsHovered = true;
 
+		// The hovered letter is only needed while the text is being clicked, not while the field is just hovered.
 		if (ParentWindow->Input.IsLMBDown && ClickStartedOnField && !(!Dragging && ParentWindow->Input.PollForText && !IsEdited))
 		{
+			size_t Nearest = TextObject->GetNearestLetterAtLocation(ParentWindow->Input.MousePosition);
 			ParentWindow->Input.PollForText = true;
-			ParentWindow->Input.Text = EnteredText;
+			SetInputText();
 			ParentWindow->Input.SetTextIndex((int)Nearest, !Dragging);
 			TextTimer = 0;
 			Dragging = true;
@@ -71,9 +76,9 @@ void UITextField::Tick()
 		{
 			IsEdited = true;
 			ParentWindow->Input.PollForText = true;
-			ParentWindow->Input.Text = EnteredText;
+			SetInputText();
 			IsPressed = false;
-			ParentWindow->Input.TextIndex = (int)Nearest;
+			ParentWindow->Input.TextIndex = (int)TextObject->GetNearestLetterAtLocation(ParentWindow->Input.MousePosition);
 			RedrawElement();
 		}
 	}
@@ -105,7 +110,7 @@ void UITextField::Tick()
 	{
 		ParentWindow->Input.TextAllowNewLine = AllowNewLine;
 		ParentWindow->Input.CanEditText = CanEdit;
-		EnteredText = ParentWindow->Input.Text;
+		UpdateEnteredText();
 		if (!ParentWindow->Input.PollForText)
 		{
 			IsEdited = false;
@@ -121,13 +126,15 @@ void UITextField::Tick()
 		}
 	}
 
-	std::string NewText = EnteredText.empty() && !IsEdited ? HintText : EnteredText;
+	bool ShowHint = EnteredText.empty() && !IsEdited;
 
-	TextObject->SetColor(EnteredText.empty() && !IsEdited ? Vec3f::Lerp(TextColor, Color, 0.25f) : TextColor);
+	TextObject->SetColor(ShowHint ? Vec3f::Lerp(TextColor, Color, 0.25f) : TextColor);
 
-	if (NewText != TextObject->GetText())
+	if (ShowHint != ShowingHint || DisplayedTextChanged)
 	{
-		TextObject->SetText(NewText);
+		TextObject->SetText(ShowHint ? HintText : EnteredText);
+		ShowingHint = ShowHint;
+		DisplayedTextChanged = false;
 		RedrawElement();
 	}
 
@@ -174,6 +181,12 @@ void UITextField::Tick()
 		if (TextHighlightStart.Y == TextHighlightEnd.Y && TextHighlightStart.X > TextHighlightEnd.X)
 			std::swap(TextHighlightStart, TextHighlightEnd);
 	}
+
+	if (!IsHovered && !IsPressed && !IsEdited && !Dragging && !ClickStartedOnField && !ShowIBeam
+		&& ParentWindow->UI.KeyboardFocusBox != this)
+	{
+		SetTickEnabled(false);
+	}
 }
 
 UITextField* UITextField::SetAllowNewLine(bool NewValue)
@@ -193,10 +206,12 @@ UITextField* UITextField::SetText(std::string NewText)
 	if (NewText != EnteredText)
 	{
 		EnteredText = NewText;
-		GetAbsoluteParent()->InvalidateLayout();
+		DisplayedTextChanged = true;
+		InvalidateLayout();
+		SetTickEnabled(true);
 		if (IsEdited)
 		{
-			ParentWindow->Input.Text = NewText;
+			SetInputText();
 		}
 	}
 	return this;
@@ -217,6 +232,8 @@ UITextField* UITextField::SetFont(Font* Font)
 UITextField* UITextField::SetHintText(std::string NewHintText)
 {
 	HintText = NewHintText;
+	DisplayedTextChanged = true;
+	SetTickEnabled(true);
 	return this;
 }
 
@@ -225,6 +242,7 @@ UITextField* UITextField::SetColor(Vec3f NewColor)
 	if (NewColor != Color)
 	{
 		Color = NewColor;
+		SetTickEnabled(true);
 		ParentWindow->UI.RedrawUI();
 	}
 	return this;
@@ -238,6 +256,7 @@ Vec3f UITextField::GetColor() const
 UITextField* UITextField::SetTextColor(Vec3f NewColor)
 {
 	TextColor = NewColor;
+	SetTickEnabled(true);
 	return this;
 }
 
@@ -267,23 +286,62 @@ UITextField::UITextField(Vec2f Position, Vec3f Color, Font* Renderer, std::funct
 	TextFieldColor = Color;
 	TextObject = new UIText(11_px, Vec3f(1), HintText, Renderer);
 	TextObject->SetPadding(3_px);
-	TextObject->Wrap = true;
+	TextObject->SetWrapEnabled(true, TextObject->GetWrapDistance());
 	HasMouseCollision = true;
 	KeyboardFocusable = true;
 	this->OnChanged = OnChanged;
 	AddChild(TextObject);
+	SetTickEnabled(true);
 }
 
 void UITextField::Edit()
 {
 	IsEdited = true;
 	ParentWindow->Input.PollForText = true;
-	ParentWindow->Input.Text = EnteredText;
+	SetInputText();
 	IsPressed = false;
 	ParentWindow->Input.SetTextIndex((int)EnteredText.size(), true);
+	SetTickEnabled(true);
 	RedrawElement();
 }
 
+void UITextField::SetInputText()
+{
+	ParentWindow->Input.Text = EnteredText;
+	SeenTextRevision = ParentWindow->Input.TextRevision;
+}
+
+void UITextField::UpdateEnteredText()
+{
+	InputManager& In = ParentWindow->Input;
+	if (In.TextRevision == SeenTextRevision && In.Text.size() == EnteredText.size())
+	{
+		return;
+	}
+
+	// Apply the changes made by the input manager, so only the edited lines of the text have to be laid out again.
+	std::vector<InputManager::TextEdit> Edits;
+	if (In.GetTextEditsSince(SeenTextRevision, Edits))
+	{
+		for (const InputManager::TextEdit& Edit : Edits)
+		{
+			EnteredText.replace(Edit.Start, Edit.RemovedLength, Edit.Inserted);
+			if (!ShowingHint && !DisplayedTextChanged)
+			{
+				TextObject->EditText(Edit.Start, Edit.RemovedLength, Edit.Inserted);
+			}
+		}
+	}
+	SeenTextRevision = In.TextRevision;
+
+	// The text has been assigned directly, or too many changes have been made since the last update.
+	if (EnteredText.size() != In.Text.size() || Edits.empty())
+	{
+		EnteredText = In.Text;
+		DisplayedTextChanged = true;
+	}
+}
+
 UITextField::~UITextField()
 {
 	if (IsEdited)
@@ -295,6 +353,13 @@ UITextField::~UITextField()
 
 void UITextField::Update()
 {
+	// The text wrapping and scrolling depend on the size of the field.
+	SetTickEnabled(true);
+}
+
+bool kui::UITextField::WantsHoverTick() const
+{
+	return true;
 }
 
 bool kui::UITextField::GetIsHovered() const
@@ -311,10 +376,12 @@ void UITextField::DrawBackground()
 {
 	TextScroll.Position = OffsetPosition;
 	TextScroll.Scale = Size;
-	
+
+	// The highlight and the cursor are drawn directly, on top of the batched background of this field.
+	FlushBatch();
+
 	BackgroundShader->Bind();
 	BoxVertexBuffer->Bind();
-	TextObject->IsVisible = true;
 
 	auto Pos = TextScroll.GetPosition();
 
@@ -331,7 +398,7 @@ void UITextField::DrawBackground()
 				BackgroundShader->SetInt("u_drawBorder", 0);
 				BackgroundShader->SetFloat("u_opacity", 0.5f);
 				Vec2f Size = End - Start;
-				glUniform4f(glGetUniformLocation(BackgroundShader->GetShaderID(), "u_transform"),
+				BackgroundShader->SetVec4("u_transform",
 					Start.X, Start.Y, Size.X, Size.Y + CharSize
 				);
 
@@ -369,7 +436,7 @@ void UITextField::DrawBackground()
 		BackgroundShader->SetInt("u_drawCorner", 0);
 		BackgroundShader->SetInt("u_drawBorder", 0);
 		BackgroundShader->SetFloat("u_opacity", 1);
-		glUniform4f(glGetUniformLocation(BackgroundShader->GetShaderID(), "u_transform"),
+		BackgroundShader->SetVec4("u_transform",
 			IBeamPosition.X, IBeamPosition.Y, IBeamScale.X, IBeamScale.Y);
 		BoxVertexBuffer->Draw();
 	}
@@ -64,6 +64,9 @@ namespace kui::markup
 
 		MarkupStructure::MarkupElement* Element = nullptr;
 
+	protected:
+		bool IsBatchedDraw() const override;
+
 	private:
 		DynamicMarkupContext* Context = nullptr;
 		std::string ElementName;
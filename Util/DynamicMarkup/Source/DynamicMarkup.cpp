@@ -116,6 +116,11 @@ kui::markup::UIDynMarkupBox::~UIDynMarkupBox()
 {
 }
 
+bool kui::markup::UIDynMarkupBox::IsBatchedDraw() const
+{
+	return true;
+}
+
 void kui::markup::UIDynMarkupBox::LoadFromElement(MarkupStructure::MarkupElement* From)
 {
 	this->Element = From;
@@ -106,7 +106,7 @@ std::vector<PropertyElement> kui::MarkupStructure::Properties
 		.Type = PropElementType::UIText,
 		.Name = "wrap",
 		.Description = "The distance before the text should wrap around.",
-		.SetFormat = { "WrapDistance = {val}", "Wrap = true" },
+		.SetFormat = { "SetWrapEnabled(true, {val})" },
 		.VarType = VariableType::SizeNumber,
 	},
 	PropertyElement{
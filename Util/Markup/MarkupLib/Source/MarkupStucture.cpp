@@ -170,6 +170,9 @@ std::string MarkupElement::WriteCode(ParseResult& MarkupElements)
 	}
 	Out << "\t}\n";
 
+	// Markup elements don't draw anything themselves, so they don't have to flush the background batch.
+	Out << "protected:\n";
+	Out << "\tbool IsBatchedDraw() const override\n\t{\n\t\treturn true;\n\t}\n";
 
 	Out << "};\n";
 	return Out.str();